@@ -830,7 +830,7 @@ TrayIcon &ApplicationCore::trayIcon()
 void ApplicationCore::updateTaskList()
 {
 #ifdef Q_OS_WIN
-    const auto recentData = DATAMODEL->mostRecentlyUsedTasks();
+    const auto recentData = DATAMODEL->mostRecentlyUsedTasks(6);
     auto recentJumpList = m_windowsJumpList->recent();
     recentJumpList->clear();
     int count = 0;
@@ -27,6 +27,8 @@
 #include <QIODevice>
 #include <QStringList>
 
+#include <climits>
+
 #include "Core/CharmDataModel.h"
 
 #include "ViewHelpers.h"
@@ -247,9 +249,9 @@ void CharmCommandSession::handleCommand(QByteArray payload)
         if (segment.count() == 2) {
             tid = segment[1].toInt(&tid_ok);
         } else {
-            EventMap::const_reverse_iterator i = DATAMODEL->eventMap().rbegin();
-            tid_ok = (i != DATAMODEL->eventMap().rend());
-            tid = i->second.taskId();
+            const TaskIdList recent = DATAMODEL->mostRecentlyUsedTasks(1);
+            tid_ok = !recent.isEmpty();
+            tid = tid_ok ? recent.first() : 0;
         }
 
         if (tid_ok && DATAMODEL->taskExists(tid)) {
@@ -314,7 +316,6 @@ void CharmCommandSession::handleCommand(QByteArray payload)
         bool count_ok;
         int offset;
         int count;
-        const EventIdList recent = DATAMODEL->mostRecentlyUsedTasks();
 
         /* default params */
 
@@ -330,11 +331,17 @@ void CharmCommandSession::handleCommand(QByteArray payload)
                 count = segment[2].toInt(&count_ok);
         }
 
+        // offset + count may not fit into an int, negative counts mean "all tasks":
+        const qint64 end = qint64(offset) + count;
+        TaskIdList recent;
+        if (offset_ok && count_ok && offset >= 0 && count >= 1)
+            recent = DATAMODEL->mostRecentlyUsedTasks(int(qMin<qint64>(end, INT_MAX)));
+
         if (offset_ok && count_ok && offset >= 0 && count >= 1 && recent.size() > offset) {
             qDebug("RECENT command received. Sending %d entries starting from offset %d", count,
                    offset);
 
-            if ((offset + count) > recent.size())
+            if (end > recent.size())
                 count = recent.size() - offset;
 
             for (int i = 0; i < count; ++i) {
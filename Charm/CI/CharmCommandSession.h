@@ -83,6 +83,10 @@ public: /* CharmDataModelAdapterInterface */
     {
     }
 
+    void eventsModified(const EventIdList &)
+    {
+    }
+
     void eventAboutToBeDeleted(EventId)
     {
     }
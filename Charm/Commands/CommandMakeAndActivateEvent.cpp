@@ -47,14 +47,11 @@ bool CommandMakeAndActivateEvent::prepare()
 
 bool CommandMakeAndActivateEvent::execute(Controller *controller)
 {
-    m_event = controller->makeEvent(m_task);
-    if (m_event.isValid()) {
-        m_event.setTaskId(m_task.id());
-        m_event.setStartDateTime(QDateTime::currentDateTime());
-        return controller->modifyEvent(m_event);
-    } else {
-        return false;
-    }
+    Event event;
+    event.setTaskId(m_task.id());
+    event.setStartDateTime(QDateTime::currentDateTime());
+    m_event = controller->cloneEvent(event);
+    return m_event.isValid();
 }
 
 bool CommandMakeAndActivateEvent::finalize()
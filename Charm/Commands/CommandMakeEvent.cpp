@@ -62,29 +62,21 @@ bool CommandMakeEvent::execute(Controller *controller)
         return m_event.isValid();
     }
 
-    Event event = controller->makeEvent(m_task);
+    // fill in the defaults, then store the event in one go:
+    Event event = m_event;
+    if (event.taskId() == 0)
+        event.setTaskId(m_task.id());
+    const QDateTime start(QDateTime::currentDateTime());
+    if (!event.startDateTime().isValid())
+        event.setStartDateTime(start);
+    if (!event.endDateTime().isValid())
+        event.setEndDateTime(start);
+
+    event = controller->cloneEvent(event);
     if (!event.isValid())
         return false;
-
-    QDateTime start(QDateTime::currentDateTime());
-    event.setStartDateTime(start);
-    event.setEndDateTime(start);
-
-    if (m_event.startDateTime().isValid())
-        event.setStartDateTime(m_event.startDateTime());
-    if (m_event.endDateTime().isValid())
-        event.setEndDateTime(m_event.endDateTime());
-    if (!m_event.comment().isEmpty())
-        event.setComment(m_event.comment());
-    if (m_event.taskId() != 0)
-        event.setTaskId(m_event.taskId());
-
-    if (controller->modifyEvent(event)) {
-        m_event = event;
-        return true;
-    } else {
-        return false;
-    }
+    m_event = event;
+    return true;
 }
 
 bool CommandMakeEvent::rollback(Controller *controller)
@@ -28,6 +28,8 @@
 #include "Core/CharmCommand.h"
 #include "Core/CharmDataModel.h"
 
+#include <algorithm>
+
 EventModelAdapter::EventModelAdapter(CharmDataModel *parent)
     : QAbstractListModel(parent)
     , m_dataModel(parent)
@@ -70,55 +72,247 @@ QVariant EventModelAdapter::data(const QModelIndex &index, int role) const
     }
 }
 
+void EventModelAdapter::setTimeWindow(const QDate &start, const QDate &end)
+{
+    const bool windowed = start.isValid() && end.isValid();
+    if (windowed == m_windowed && (!windowed || (start == m_spanStart && end == m_windowEnd)))
+        return;
+    m_windowed = windowed;
+    m_spanStart = windowed ? start : QDate();
+    m_windowEnd = windowed ? end : QDate();
+    m_lookbackDays = -1;
+    if (windowed)
+        m_windowEndSecs = QDateTime(end, QTime(0, 0)).toSecsSinceEpoch();
+    resetEvents();
+}
+
+bool EventModelAdapter::extendWindow()
+{
+    // events that start before the span may end within it:
+    const int SecondsPerDay = 24 * 60 * 60;
+    const int lookbackDays = m_dataModel->longestEventDuration() / SecondsPerDay + 1;
+    if (lookbackDays <= m_lookbackDays)
+        return false;
+    m_lookbackDays = lookbackDays;
+    m_windowStart = m_spanStart.addDays(-lookbackDays);
+    m_windowStartSecs = QDateTime(m_windowStart, QTime(0, 0)).toSecsSinceEpoch();
+    return true;
+}
+
+bool EventModelAdapter::isWindowed() const
+{
+    return m_windowed;
+}
+
 void EventModelAdapter::resetEvents()
 {
     beginResetModel();
 
     m_events.clear();
 
-    for (EventMap::const_iterator it = m_dataModel->eventMap().begin();
-         it != m_dataModel->eventMap().end(); ++it)
-        m_events.append(it->first);
+    if (m_windowed) {
+        extendWindow();
+        // the time index returns the events in start time order:
+        m_events = m_dataModel->eventsThatStartInTimeFrame(m_windowStart, m_windowEnd);
+    } else {
+        m_events.reserve(m_dataModel->eventStore().size());
+        for (const Event &event : m_dataModel->eventStore())
+            m_events.append(event.id());
+        // the store is not ordered, keep the rows in id order:
+        std::sort(m_events.begin(), m_events.end());
+    }
+    m_rows.clear();
+    m_rows.reserve(m_events.size());
+    for (int row = 0; row < m_events.size(); ++row)
+        m_rows.insert(m_events.at(row), row);
+    m_validRows = m_events.size();
 
     endResetModel();
 }
 
 void EventModelAdapter::eventAboutToBeAdded(EventId)
 {
+    // in a time window, the position is known once the event has been added:
+    if (m_windowed)
+        return;
     int position = m_events.size();
     beginInsertRows(QModelIndex(), position, position);
 }
 
 void EventModelAdapter::eventAdded(EventId id)
 {
+    if (m_windowed) {
+        if (extendWindow()) {
+            resetEvents();
+            return;
+        }
+        const Event &event = m_dataModel->eventForId(id);
+        if (isInWindow(event))
+            insertRow(id, insertionRow(event, -1));
+        return;
+    }
+    m_rows.insert(id, m_events.size());
     m_events.append(id);
     endInsertRows();
 }
 
 void EventModelAdapter::eventModified(EventId id, Event)
 {
+    if (m_windowed) {
+        if (extendWindow())
+            resetEvents();
+        else
+            updateWindowedRow(id);
+        return;
+    }
     // nothing to do, except:
-    int row = m_events.indexOf(id);
+    int row = rowForEvent(id);
     Q_ASSERT(row != -1);   // inconsistency between model and adapter
     emit(dataChanged(index(row), index(row)));
 }
 
+void EventModelAdapter::eventsModified(const EventIdList &ids)
+{
+    if (m_windowed && extendWindow()) {
+        resetEvents();
+        return;
+    }
+
+    // one notification for the range of rows that contains all modified events:
+    int first = m_events.size();
+    int last = -1;
+    bool moved = false;
+    Q_FOREACH (EventId id, ids) {
+        const int row = rowForEvent(id);
+        if (m_windowed) {
+            // events that enter or leave the window, or change their position, are moved:
+            if (row == -1 ? isInWindow(m_dataModel->eventForId(id)) : !isInPlace(row))
+                moved = true;
+            if (row == -1)
+                continue;
+        }
+        Q_ASSERT(row != -1);   // inconsistency between model and adapter
+        if (row == -1)
+            continue;
+        first = qMin(first, row);
+        last = qMax(last, row);
+    }
+    if (moved) {
+        resetEvents();
+    } else if (last != -1) {
+        emit dataChanged(index(first), index(last));
+    }
+}
+
 void EventModelAdapter::eventAboutToBeDeleted(EventId id)
 {
-    int row = m_events.indexOf(id);
+    int row = rowForEvent(id);
+    if (m_windowed && row == -1)
+        return;   // not in the window
     Q_ASSERT(row != -1);   // inconsistency between model and adapter
     beginRemoveRows(QModelIndex(), row, row);
 }
 
 void EventModelAdapter::eventDeleted(EventId id)
 {
-    int position = m_events.indexOf(id);
+    int position = rowForEvent(id);
+    if (m_windowed && position == -1)
+        return;   // not in the window
     Q_ASSERT(position != -1);   // inconsistency between model and adapter
     m_events.removeAt(position);
-    Q_ASSERT(m_events.indexOf(id) == -1);      // cannot be in there
+    m_rows.remove(id);
+    // the following rows move up by one:
+    invalidateRows(position);
+    Q_ASSERT(rowForEvent(id) == -1);      // cannot be in there
     endRemoveRows();
 }
 
+bool EventModelAdapter::isInWindow(const Event &event) const
+{
+    const qint64 start = event.startSecsSinceEpoch();
+    return start != Event::InvalidTime && start >= m_windowStartSecs && start < m_windowEndSecs;
+}
+
+bool EventModelAdapter::startsBefore(const Event &left, const Event &right)
+{
+    // the order of the time index of the model:
+    return left.startSecsSinceEpoch() < right.startSecsSinceEpoch()
+           || (left.startSecsSinceEpoch() == right.startSecsSinceEpoch() && left.id() < right.id());
+}
+
+bool EventModelAdapter::isInPlace(int row) const
+{
+    const Event &event = m_dataModel->eventForId(m_events.at(row));
+    if (!isInWindow(event))
+        return false;
+    if (row > 0 && !startsBefore(m_dataModel->eventForId(m_events.at(row - 1)), event))
+        return false;
+    if (row + 1 < m_events.size() && !startsBefore(event, m_dataModel->eventForId(m_events.at(row + 1))))
+        return false;
+    return true;
+}
+
+int EventModelAdapter::insertionRow(const Event &event, int skipRow) const
+{
+    // binary search in the rows, as if skipRow had already been removed:
+    int first = 0;
+    int count = m_events.size() - (skipRow == -1 ? 0 : 1);
+    while (count > 0) {
+        const int step = count / 2;
+        int row = first + step;
+        if (skipRow != -1 && row >= skipRow)
+            ++row;
+        if (startsBefore(m_dataModel->eventForId(m_events.at(row)), event)) {
+            first += step + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+    return first;
+}
+
+void EventModelAdapter::insertRow(EventId id, int row)
+{
+    beginInsertRows(QModelIndex(), row, row);
+    m_events.insert(row, id);
+    m_rows.insert(id, row);
+    invalidateRows(row);
+    endInsertRows();
+}
+
+void EventModelAdapter::updateWindowedRow(EventId id)
+{
+    const Event &event = m_dataModel->eventForId(id);
+    const int row = rowForEvent(id);
+    if (row == -1) {
+        // the event may have entered the window:
+        if (isInWindow(event))
+            insertRow(id, insertionRow(event, -1));
+        return;
+    }
+
+    if (!isInWindow(event)) {
+        // the event left the window:
+        beginRemoveRows(QModelIndex(), row, row);
+        m_events.removeAt(row);
+        m_rows.remove(id);
+        invalidateRows(row);
+        endRemoveRows();
+    } else if (isInPlace(row)) {
+        emit dataChanged(index(row), index(row));
+    } else {
+        // the position after the row has been taken out, in the numbering without it:
+        const int newRow = insertionRow(event, row);
+        // beginMoveRows() expects the destination in the numbering before the move:
+        beginMoveRows(QModelIndex(), row, row, QModelIndex(), newRow > row ? newRow + 1 : newRow);
+        m_events.move(row, newRow);
+        invalidateRows(qMin(row, newRow));
+        endMoveRows();
+        emit dataChanged(index(newRow), index(newRow));
+    }
+}
+
 void EventModelAdapter::eventActivated(EventId id)
 {
     emit eventActivationNotice(id);
@@ -148,7 +342,7 @@ const Event &EventModelAdapter::eventForIndex(const QModelIndex &index) const
 
 QModelIndex EventModelAdapter::indexForEvent(const Event &event) const
 {
-    int position = m_events.indexOf(event.id());
+    int position = rowForEvent(event.id());
 
     if (position >= 0 && position < m_events.size()) {
         return index(position);
@@ -156,3 +350,26 @@ QModelIndex EventModelAdapter::indexForEvent(const Event &event) const
         return QModelIndex();
     }
 }
+
+int EventModelAdapter::rowForEvent(EventId id) const
+{
+    const int row = m_rows.value(id, -1);
+    if (row == -1 || (row < m_events.size() && m_events.at(row) == id))
+        return row;
+
+    // the stored row is outdated, renumber the rows up to the one of the event:
+    while (m_validRows < m_events.size()) {
+        const int validRow = m_validRows++;
+        const EventId validId = m_events.at(validRow);
+        m_rows[validId] = validRow;
+        if (validId == id)
+            return validRow;
+    }
+    Q_ASSERT(false);   // every event in m_rows is in m_events
+    return -1;
+}
+
+void EventModelAdapter::invalidateRows(int from)
+{
+    m_validRows = qMin(m_validRows, from);
+}
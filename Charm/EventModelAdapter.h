@@ -26,6 +26,8 @@
 #define EVENTMODELADAPTER_H
 
 #include <QAbstractItemModel>
+#include <QDate>
+#include <QHash>
 #include <QPointer>
 
 #include "Core/Event.h"
@@ -48,6 +50,15 @@ public:
 
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
 
+    /** Only provide the events that start before @p end and may end after @p start.
+        These are the events that start at most the duration of the longest event
+        before @p start. The window is extended when an event becomes longer than that.
+        The rows are taken from the time index of the model, in start time order, and
+        are kept up to date as events enter or leave the window. With invalid dates,
+        all events are provided, ordered by id. */
+    void setTimeWindow(const QDate &start, const QDate &end);
+    bool isWindowed() const;
+
     // reimplement CharmDataModelAdapterInterface:
     void resetTasks() override
     {
@@ -81,6 +92,7 @@ public:
     void eventAboutToBeAdded(EventId id) override;
     void eventAdded(EventId id) override;
     void eventModified(EventId id, Event) override;
+    void eventsModified(const EventIdList &ids) override;
     void eventAboutToBeDeleted(EventId id) override;
     void eventDeleted(EventId id) override;
 
@@ -99,8 +111,35 @@ Q_SIGNALS:
     void eventDeactivationNotice(EventId id);
 
 private:
-    // if this is slow, we may want to store pointers here:
+    /** Returns the row of the event, or -1. */
+    int rowForEvent(EventId id) const;
+    // the stored rows from this row on may be outdated after rows were inserted,
+    // removed or moved. They are renumbered on demand by rowForEvent():
+    void invalidateRows(int from);
+
+    // maintenance of the rows in a time window:
+    bool isInWindow(const Event &event) const;
+    // move the start of the window back if the longest event does not fit anymore:
+    bool extendWindow();
+    static bool startsBefore(const Event &left, const Event &right);
+    bool isInPlace(int row) const;
+    int insertionRow(const Event &event, int skipRow) const;
+    void insertRow(EventId id, int row);
+    void updateWindowedRow(EventId id);
+
     EventIdList m_events;
+    // the row of every event in m_events, only the rows below m_validRows are
+    // known to be up to date:
+    mutable QHash<EventId, int> m_rows;
+    mutable int m_validRows = 0;
+    bool m_windowed = false;
+    QDate m_spanStart;
+    // the number of days the window starts before the span:
+    int m_lookbackDays = 0;
+    QDate m_windowStart;
+    QDate m_windowEnd;
+    qint64 m_windowStartSecs = 0;
+    qint64 m_windowEndSecs = 0;
     QPointer<CharmDataModel> m_dataModel;
 };
 
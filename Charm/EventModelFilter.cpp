@@ -24,14 +24,33 @@
 
 #include "EventModelFilter.h"
 
+#include "Core/CharmDataModel.h"
+
 EventModelFilter::EventModelFilter(CharmDataModel *model, QObject *parent)
     : QSortFilterProxyModel(parent)
+    , m_dataModel(model)
     , m_model(model)
 {
+    // the totals follow the rows of the proxy:
+    connect(this, SIGNAL(rowsInserted(QModelIndex,int,int)),
+            SLOT(slotRowsInserted(QModelIndex,int,int)));
+    connect(this, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)),
+            SLOT(slotRowsAboutToBeRemoved(QModelIndex,int,int)));
+    connect(this, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+            SLOT(slotDataChanged(QModelIndex,QModelIndex)));
+    connect(this, SIGNAL(modelReset()), SLOT(recalculateTotals()));
+    // sorting only reorders the rows, so layout changes keep the totals.
+
     setSourceModel(&m_model);
     setDynamicSortFilter(true);
     sort(0, Qt::AscendingOrder);
 
+    // when the source moves a row within its time window, the proxy filters all rows
+    // again, without notifying about the rows it drops or adds. This happens when the
+    // start of an event is changed, connected after the proxy handled the move:
+    connect(&m_model, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)),
+            SLOT(recalculateTotals()));
+
     connect(&m_model, SIGNAL(eventActivationNotice(EventId)),
             SIGNAL(eventActivationNotice(EventId)));
     connect(&m_model, SIGNAL(eventDeactivationNotice(EventId)),
@@ -98,20 +117,38 @@ bool EventModelFilter::filterAcceptsRow(int srow, const QModelIndex &sparent) co
 
 void EventModelFilter::setFilterStartDate(const QDate &date)
 {
-    if (m_start == date)
-        return;
-    m_start = date;
-    invalidateFilter();
+    setFilterTimeSpan(date, m_end);
 }
 
 void EventModelFilter::setFilterEndDate(const QDate &date)
 {
-    if (m_end == date)
+    setFilterTimeSpan(m_start, date);
+}
+
+void EventModelFilter::setFilterTimeSpan(const QDate &start, const QDate &end)
+{
+    if (m_start == start && m_end == end)
         return;
-    m_end = date;
+    m_start = start;
+    m_end = end;
+    updateTimeWindow();
     invalidateFilter();
 }
 
+void EventModelFilter::updateTimeWindow()
+{
+    // load older events of the time span on demand, without a start date,
+    // the filter accepts all events:
+    m_dataModel->requireEvents(m_start, m_end);
+
+    // only the events in the time span are provided by the source model, including
+    // the ones that start before and end within the time span:
+    const bool windowed = m_start.isValid() && m_end.isValid();
+    m_model.setTimeWindow(m_start, m_end);
+    // the rows of a time window are already in start time order:
+    sort(windowed ? -1 : 0, Qt::AscendingOrder);
+}
+
 void EventModelFilter::setFilterTaskId(TaskId id)
 {
     if (m_filterId == id)
@@ -122,13 +159,68 @@ void EventModelFilter::setFilterTaskId(TaskId id)
 
 int EventModelFilter::totalDuration() const
 {
-    int total = 0;
-    for (int i = 0; i < rowCount(); ++i) {
-        QModelIndex current = index(i, 0, QModelIndex());
-        const Event &event = eventForIndex(current);
-        total += event.duration();
+    return m_totalDuration;
+}
+
+QSet<EventId> EventModelFilter::eventIds() const
+{
+    return m_eventIds;
+}
+
+bool EventModelFilter::containsEvent(EventId id) const
+{
+    return m_eventIds.contains(id);
+}
+
+void EventModelFilter::addToTotals(const Event &event)
+{
+    if (!event.isValid() || m_durations.contains(event.id()))
+        return;
+    const int duration = event.duration();
+    m_durations.insert(event.id(), duration);
+    m_eventIds.insert(event.id());
+    m_totalDuration += duration;
+}
+
+void EventModelFilter::removeFromTotals(EventId id)
+{
+    const auto it = m_durations.find(id);
+    if (it == m_durations.end())
+        return;
+    m_totalDuration -= it.value();
+    m_durations.erase(it);
+    m_eventIds.remove(id);
+}
+
+void EventModelFilter::recalculateTotals()
+{
+    m_durations.clear();
+    m_eventIds.clear();
+    m_totalDuration = 0;
+    for (int i = 0; i < rowCount(); ++i)
+        addToTotals(eventForIndex(index(i, 0)));
+}
+
+void EventModelFilter::slotRowsInserted(const QModelIndex &parent, int first, int last)
+{
+    for (int row = first; row <= last; ++row)
+        addToTotals(eventForIndex(index(row, 0, parent)));
+}
+
+void EventModelFilter::slotRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last)
+{
+    for (int row = first; row <= last; ++row)
+        removeFromTotals(eventForIndex(index(row, 0, parent)).id());
+}
+
+void EventModelFilter::slotDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    // the durations of active events change with every update:
+    for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+        const Event &event = eventForIndex(index(row, 0));
+        removeFromTotals(event.id());
+        addToTotals(event);
     }
-    return total;
 }
 
 QList<Event> EventModelFilter::events() const
@@ -26,6 +26,8 @@
 #define EVENTMODELFILTER_H
 
 #include <QDate>
+#include <QHash>
+#include <QSet>
 #include <QSortFilterProxyModel>
 
 #include <Core/EventModelInterface.h>
@@ -44,8 +46,12 @@ public:
     explicit EventModelFilter(CharmDataModel *, QObject *parent = nullptr);
     ~EventModelFilter() override;
 
-    /** Returns the total number of seconds of all events in the model. */
+    /** Returns the total number of seconds of all events in the model.
+        The total is updated with every change of the rows. */
     int totalDuration() const;
+    /** The ids of all events in the model. */
+    QSet<EventId> eventIds() const;
+    bool containsEvent(EventId id) const;
 
     // implement EventModelInterface:
     const Event &eventForIndex(const QModelIndex &) const override;
@@ -55,6 +61,10 @@ public:
 
     void setFilterStartDate(const QDate &date);
     void setFilterEndDate(const QDate &date);
+    /** Set both ends of the time span at once. The events of the time span are
+        loaded on demand, setting the ends one by one may load an intermediate
+        time span. */
+    void setFilterTimeSpan(const QDate &start, const QDate &end);
     void setFilterTaskId(TaskId id);
 
     // implement CommandEmitterInterface:
@@ -69,11 +79,28 @@ Q_SIGNALS:
     void eventActivationNotice(EventId id);
     void eventDeactivationNotice(EventId id);
 
+private Q_SLOTS:
+    void slotRowsInserted(const QModelIndex &parent, int first, int last);
+    void slotRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void slotDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void recalculateTotals();
+
 private:
+    void addToTotals(const Event &event);
+    void removeFromTotals(EventId id);
+
+    // restrict the source model to the filtered time span:
+    void updateTimeWindow();
+
+    CharmDataModel *m_dataModel;
     EventModelAdapter m_model;
     QDate m_start;
     QDate m_end;
     TaskId m_filterId = {};
+    // the duration of every event in the model, and their sum:
+    QHash<EventId, int> m_durations;
+    QSet<EventId> m_eventIds;
+    int m_totalDuration = 0;
 };
 
 #endif
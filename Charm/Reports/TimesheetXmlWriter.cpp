@@ -30,6 +30,7 @@
 #include "Core/XmlSerialization.h"
 
 #include <QDomDocument>
+#include <QSet>
 
 TimesheetXmlWriter::TimesheetXmlWriter(const QString &templateName)
     : m_templateName(templateName)
@@ -120,14 +121,15 @@ QByteArray TimesheetXmlWriter::saveToXml() const
         QDomElement effort = document.createElement(QStringLiteral("effort"));
         report.appendChild(effort);
 
-        // aggregate (group by task and day):
+        // aggregate (group by task and day). The comments are joined as well, which
+        // is why the events are visited instead of the duration table of the model:
+        QSet<TaskId> reportedTasks;
+        Q_FOREACH (const TimeSheetInfo &info, timeSheetInfo)
+            reportedTasks.insert(info.taskId);
         typedef QPair<TaskId, QDate> Key;
         QMap< Key, Event> events;
         Q_FOREACH (const Event &event, m_events) {
-            TimeSheetInfoList::iterator it;
-            for (it = timeSheetInfo.begin(); it != timeSheetInfo.end(); ++it)
-                if ((*it).taskId == event.taskId()) break;
-            if (it == timeSheetInfo.end())
+            if (!reportedTasks.contains(event.taskId()))
                 continue;
             Key key(event.taskId(), event.startDateTime().date());
             if (events.contains(key)) {
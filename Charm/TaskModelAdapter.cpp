@@ -39,7 +39,9 @@
 TaskModelAdapter::TaskModelAdapter(CharmDataModel *parent)
     : QAbstractItemModel()
     , m_dataModel(parent)
+    , m_expiredBackgroundColor(QStringLiteral("crimson"))
 {
+    m_expiredBackgroundColor.setAlphaF(0.25);
     m_dataModel->registerAdapter(this);
 }
 
@@ -74,30 +76,27 @@ QVariant TaskModelAdapter::data(const QModelIndex &index, int role) const
     const TaskId id = item->task().id();
     const Event &activeEvent = m_dataModel->activeEventFor(id);
     const bool isActive = activeEvent.isValid();
-    const QApplication *application = static_cast<QApplication *>(QApplication::instance());
-    Q_ASSERT(application);   // we assume this code is executed in a GUI app
 
     // handle roles that are treated all the same, everywhere:
     switch (role) {
     // problem: foreground role is never queried for
     case Qt::ForegroundRole:
+        updateColors();
         if (item->task().isCurrentlyValid()) {
-            return application->palette().color(QPalette::Active, QPalette::Text);
+            return m_validTextColor;
         } else {
-            return application->palette().color(QPalette::Disabled, QPalette::Text);
+            return m_expiredTextColor;
         }
         break;
     case Qt::BackgroundRole:
         if (item->task().isCurrentlyValid()) {
             return QVariant();
         } else {
-            QColor color("crimson");
-            color.setAlphaF(0.25);
-            return color;
+            return m_expiredBackgroundColor;
         }
         break;
     case Qt::DisplayRole:
-        return DATAMODEL->taskIdAndNameString(item->task().id());
+        return taskStrings(id).idAndName;
     case Qt::DecorationRole:
         if (isActive) {
             return Data::activePixmap();
@@ -124,7 +123,7 @@ QVariant TaskModelAdapter::data(const QModelIndex &index, int role) const
     case TasksViewRole_UserComment:
         return activeEvent.comment();
     case TasksViewRole_Filter:
-        return DATAMODEL->taskIdAndFullNameString(item->task().id());
+        return taskStrings(id).idAndFullName;
     default:
         return QVariant();
     }
@@ -213,12 +212,15 @@ bool TaskModelAdapter::setData(const QModelIndex &index, const QVariant &value,
 
 void TaskModelAdapter::resetTasks()
 {
+    emit tasksChanged();
     beginResetModel();
+    m_taskStrings.clear();
     endResetModel();
 }
 
 void TaskModelAdapter::taskAboutToBeAdded(TaskId parentId, int pos)
 {
+    emit tasksChanged();
     const TaskTreeItem &parent = m_dataModel->taskTreeItem(parentId);
     beginInsertRows(indexForTaskTreeItem(parent, 0), pos, pos);
 }
@@ -230,6 +232,10 @@ void TaskModelAdapter::taskAdded(TaskId)
 
 void TaskModelAdapter::taskParentChanged(TaskId task, TaskId oldParent, TaskId newParent)
 {
+    emit tasksChanged();
+    // the full names of the task and its children change:
+    invalidateTaskStrings(task);
+
     // remove task from old parent:
     const TaskTreeItem &item = m_dataModel->taskTreeItem(task);
     const int row = item.row();
@@ -246,6 +252,13 @@ void TaskModelAdapter::taskParentChanged(TaskId task, TaskId oldParent, TaskId n
 }
 
 void TaskModelAdapter::taskModified(TaskId id)
+{
+    invalidateTaskStrings(id);
+    emit tasksChanged();
+    emitTaskDataChanged(id);
+}
+
+void TaskModelAdapter::emitTaskDataChanged(TaskId id)
 {
     const TaskTreeItem &item = m_dataModel->taskTreeItem(id);
     if (item.isValid()) {
@@ -257,11 +270,13 @@ void TaskModelAdapter::taskModified(TaskId id)
 
 void TaskModelAdapter::taskAboutToBeDeleted(TaskId id)
 {
+    emit tasksChanged();
     const TaskTreeItem &item = m_dataModel->taskTreeItem(id);
     const TaskTreeItem &parent = m_dataModel->parentItem(item.task());
     int row = item.row();
     Q_ASSERT(row != -1);
 
+    m_taskStrings.remove(id);
     beginRemoveRows(indexForTaskTreeItem(parent, 0), row, row);
 }
 
@@ -273,7 +288,7 @@ void TaskModelAdapter::taskDeleted(TaskId)
 void TaskModelAdapter::eventAdded(EventId id)
 {
     const Event &event = m_dataModel->eventForId(id);
-    taskModified(event.taskId());
+    emitTaskDataChanged(event.taskId());
 }
 
 void TaskModelAdapter::eventModified(EventId id, Event)
@@ -293,6 +308,19 @@ void TaskModelAdapter::eventModified(EventId id, Event)
     }
 }
 
+void TaskModelAdapter::eventsModified(const EventIdList &ids)
+{
+    // update every task once:
+    QSet<TaskId> tasks;
+    Q_FOREACH (EventId id, ids) {
+        const TaskId taskId = m_dataModel->eventForId(id).taskId();
+        if (tasks.contains(taskId))
+            continue;
+        tasks.insert(taskId);
+        emitTaskDataChanged(taskId);
+    }
+}
+
 void TaskModelAdapter::eventDeleted(EventId id)
 {
     eventAdded(id);
@@ -303,7 +331,7 @@ void TaskModelAdapter::eventActivated(EventId id)
     // query the model to find out the task:
     const Event &event = m_dataModel->eventForId(id);
     if (event.isValid()) {
-        taskModified(event.taskId());
+        emitTaskDataChanged(event.taskId());
         emit eventActivationNotice(id);
     }
 }
@@ -313,7 +341,7 @@ void TaskModelAdapter::eventDeactivated(EventId id)
     // query the model to find out the task:
     const Event &event = m_dataModel->eventForId(id);
     if (event.isValid()) {
-        taskModified(event.taskId());
+        emitTaskDataChanged(event.taskId());
         emit eventDeactivationNotice(id);
     }
 }
@@ -327,6 +355,43 @@ const TaskTreeItem *TaskModelAdapter::itemFor(const QModelIndex &index) const
     }
 }
 
+const TaskModelAdapter::TaskStrings &TaskModelAdapter::taskStrings(TaskId id) const
+{
+    TaskStrings &strings = m_taskStrings[id];
+    // the padding changes when a task with a longer id is added:
+    if (strings.idPadding != CONFIGURATION.taskPaddingLength) {
+        strings.idPadding = CONFIGURATION.taskPaddingLength;
+        strings.idAndName = m_dataModel->taskIdAndNameString(id);
+        strings.idAndFullName = m_dataModel->taskIdAndFullNameString(id);
+    }
+    return strings;
+}
+
+void TaskModelAdapter::invalidateTaskStrings(TaskId id)
+{
+    // the full names of all tasks in the subtree contain the name of this task:
+    if (m_taskStrings.isEmpty())
+        return;
+    QVector<const TaskTreeItem *> items { &m_dataModel->taskTreeItem(id) };
+    while (!items.isEmpty()) {
+        const TaskTreeItem *item = items.takeLast();
+        m_taskStrings.remove(item->task().id());
+        for (int row = 0; row < item->childCount(); ++row)
+            items.append(&item->child(row));
+    }
+}
+
+void TaskModelAdapter::updateColors() const
+{
+    const QPalette palette = QApplication::palette();
+    if (palette.cacheKey() == m_paletteCacheKey)
+        return;
+
+    m_paletteCacheKey = palette.cacheKey();
+    m_validTextColor = palette.color(QPalette::Active, QPalette::Text);
+    m_expiredTextColor = palette.color(QPalette::Disabled, QPalette::Text);
+}
+
 QModelIndex TaskModelAdapter::indexForTaskTreeItem(const TaskTreeItem &item, int column) const
 {
     if (item.isValid()) {
@@ -26,6 +26,8 @@
 #define TASKMODELADAPTER_H
 
 #include <QAbstractItemModel>
+#include <QColor>
+#include <QHash>
 #include <QPointer>
 
 #include "Core/TaskModelInterface.h"
@@ -94,6 +96,7 @@ public:
 
     void eventAdded(EventId) override;
     void eventModified(EventId, Event) override;
+    void eventsModified(const EventIdList &ids) override;
     void eventAboutToBeDeleted(EventId) override
     {
     }
@@ -117,12 +120,31 @@ public:
 Q_SIGNALS:
     void eventActivationNotice(EventId id) override;
     void eventDeactivationNotice(EventId id) override;
+    // emitted before the rows are updated for added, modified, moved or deleted tasks,
+    // but not for the data changes caused by events:
+    void tasksChanged();
 
 private:
+    // the display and filter strings are formatted once per task:
+    struct TaskStrings {
+        int idPadding = -1;
+        QString idAndName;
+        QString idAndFullName;
+    };
+
     const TaskTreeItem *itemFor(const QModelIndex &) const;
     QModelIndex indexForTaskTreeItem(const TaskTreeItem &item, int column = 0) const;
+    void emitTaskDataChanged(TaskId id);
+    const TaskStrings &taskStrings(TaskId id) const;
+    void invalidateTaskStrings(TaskId id);
+    void updateColors() const;
 
     QPointer<CharmDataModel> m_dataModel;
+    mutable QHash<TaskId, TaskStrings> m_taskStrings;
+    mutable qint64 m_paletteCacheKey = 0;
+    mutable QColor m_validTextColor;
+    mutable QColor m_expiredTextColor;
+    QColor m_expiredBackgroundColor;
 };
 
 #endif
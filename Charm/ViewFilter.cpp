@@ -30,6 +30,12 @@ ViewFilter::ViewFilter(CharmDataModel *model, QObject *parent)
     : QSortFilterProxyModel(parent)
     , m_model(model)
 {
+    // the flags only depend on the tasks, not on their events. The adapter
+    // notifies before the rows change, so that the proxy filters them with
+    // the new flags:
+    connect(&m_model, &TaskModelAdapter::tasksChanged,
+            this, &ViewFilter::invalidateTaskFlags);
+
     setSourceModel(&m_model);
 
     // we filter for the task name column
@@ -72,56 +78,86 @@ bool ViewFilter::taskHasChildren(const Task &task) const
 
 void ViewFilter::prefilteringModeChanged()
 {
+    invalidateTaskFlags();
     invalidate();
 }
 
-bool ViewFilter::filterAcceptsRow(int source_row, const QModelIndex &parent) const
+void ViewFilter::setFilterText(const QString &wildcard)
 {
-    // by default, QSortFilterProxyModel only accepts row where already the parents where accepted
-    bool acceptedByFilter = QSortFilterProxyModel::filterAcceptsRow(source_row, parent);
-    // in our case, this is not what we want, we want parents to be
-    // accepted if any of their children are accepted (this is a
-    // recursive call, and could possibly be slow):
-    const QModelIndex index(m_model.index(source_row, 0, parent));
-    if (!index.isValid()) return acceptedByFilter;
-
-    int rowCount = m_model.rowCount(index);
-    for (int i = 0; i < rowCount; ++i) {
-        if (filterAcceptsRow(i, index)) {
-            acceptedByFilter = true;
-            break;
-        }
-    }
+    invalidateTaskFlags();
+    setFilterWildcard(wildcard);
+}
+
+void ViewFilter::invalidateTaskFlags()
+{
+    m_taskFlagsValid = false;
+}
+
+void ViewFilter::updateTaskFlags() const
+{
+    if (m_taskFlagsValid)
+        return;
+
+    m_taskFlags.clear();
+    calculateTaskFlags(QModelIndex(), QDateTime::currentDateTime(),
+                       Configuration::instance().taskPrefilteringMode);
+    m_taskFlagsValid = true;
+}
+
+int ViewFilter::calculateTaskFlags(const QModelIndex &index, const QDateTime &now,
+                                   Configuration::TaskPrefilteringMode mode) const
+{
+    // the children are visited first, their flags are accumulated into the parent:
+    int childFlags = 0;
+    const int rowCount = m_model.rowCount(index);
+    for (int i = 0; i < rowCount; ++i)
+        childFlags |= calculateTaskFlags(m_model.index(i, 0, index), now, mode);
+
+    if (!index.isValid())
+        return 0;
 
-    bool accepted = acceptedByFilter;
     const Task task = m_model.taskForIndex(index);
-    switch (Configuration::instance().taskPrefilteringMode) {
+    int flags = childFlags & (HasSubscribed | HasCurrentlyValid);
+    if (task.subscribed())
+        flags |= HasSubscribed;
+    if (task.isCurrentlyValid(now))
+        flags |= HasCurrentlyValid;
+    if (QSortFilterProxyModel::filterAcceptsRow(index.row(), index.parent()))
+        flags |= MatchesText;
+
+    // by default, QSortFilterProxyModel only accepts rows where already the parents
+    // were accepted, in our case parents are accepted if any of their children are:
+    bool accepted = (flags & MatchesText) || (childFlags & Accepted);
+    switch (mode) {
     case Configuration::TaskPrefilter_ShowAll:
         break;
     case Configuration::TaskPrefilter_CurrentOnly:
-    {
-        const bool ok = (task.isCurrentlyValid() || checkChildren(task, HaveValidChild));
-        accepted &= ok;
+        accepted &= (flags & HasCurrentlyValid) != 0;
         break;
-    }
     case Configuration::TaskPrefilter_SubscribedOnly:
-    {
-        const bool ok = (task.subscribed() || checkChildren(task, HaveSubscribedChild));
-        accepted &= ok;
+        accepted &= (flags & HasSubscribed) != 0;
         break;
-    }
     case Configuration::TaskPrefilter_SubscribedAndCurrentOnly:
-        accepted
-            &= ((task.subscribed()
-                 || checkChildren(task,
-                                  HaveSubscribedChild))
-                && (task.isCurrentlyValid() || checkChildren(task, HaveValidChild)));
+        accepted &= (flags & HasSubscribed) && (flags & HasCurrentlyValid);
         break;
     default:
         break;
     }
+    if (accepted)
+        flags |= Accepted;
 
-    return accepted;
+    m_taskFlags.insert(task.id(), flags);
+    return flags;
+}
+
+bool ViewFilter::filterAcceptsRow(int source_row, const QModelIndex &parent) const
+{
+    const QModelIndex index(m_model.index(source_row, 0, parent));
+    if (!index.isValid())
+        return QSortFilterProxyModel::filterAcceptsRow(source_row, parent);
+
+    updateTaskFlags();
+    return m_taskFlags.value(m_model.taskForIndex(index).id()) & Accepted;
 }
 
 bool ViewFilter::filterAcceptsColumn(int, const QModelIndex &) const
@@ -134,21 +170,6 @@ bool ViewFilter::taskIdExists(TaskId taskId) const
     return m_model.taskIdExists(taskId);
 }
 
-bool ViewFilter::checkChildren(Task task, CheckFor checkFor) const
-{
-    if (taskHasChildren(task)) {
-        const TaskList taskList = m_model.children(task);
-        for (const Task &taskChild : taskList) {
-            if (checkFor == HaveSubscribedChild && taskChild.subscribed()) {
-                return true;
-            } else if (checkFor == HaveValidChild && taskChild.isCurrentlyValid()) {
-                return true;
-            }
-        }
-    }
-    return false;
-}
-
 void ViewFilter::commitCommand(CharmCommand *command)
 {   // we do not emit signals, we are the relay (since we are a proxy):
     m_model.commitCommand(command);
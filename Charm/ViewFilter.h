@@ -25,6 +25,7 @@
 #ifndef VIEWFILTER_H
 #define VIEWFILTER_H
 
+#include <QHash>
 #include <QSortFilterProxyModel>
 
 #include "Core/Configuration.h"
@@ -53,6 +54,9 @@ public:
 
     // filter for subscriptions:
     void prefilteringModeChanged();
+    // set the wildcard filter text, use this instead of setFilterWildcard()
+    // so that the cached task flags are updated:
+    void setFilterText(const QString &wildcard);
 
     bool taskIdExists(TaskId taskId) const override;
     void commitCommand(CharmCommand *) override;
@@ -63,14 +67,28 @@ Q_SIGNALS:
     void eventActivationNotice(EventId id) override;
     void eventDeactivationNotice(EventId id) override;
 
+private Q_SLOTS:
+    void invalidateTaskFlags();
+
 private:
-    enum CheckFor {
-        HaveValidChild,
-        HaveSubscribedChild
+    enum TaskFlag {
+        MatchesText = 0x01,
+        // the task or one of its descendants is subscribed:
+        HasSubscribed = 0x02,
+        // the task or one of its descendants is currently valid:
+        HasCurrentlyValid = 0x04,
+        Accepted = 0x08
     };
 
-    bool checkChildren(Task task, CheckFor checkFor) const;
+    void updateTaskFlags() const;
+    int calculateTaskFlags(const QModelIndex &index, const QDateTime &now,
+                           Configuration::TaskPrefilteringMode mode) const;
+
     TaskModelAdapter m_model;
+    // the flags of all tasks, calculated in one pass over the task tree
+    // whenever the tasks or the filter settings changed:
+    mutable QHash<TaskId, int> m_taskFlags;
+    mutable bool m_taskFlagsValid = false;
 };
 
 #endif
@@ -24,6 +24,8 @@
 #include "WeeklySummary.h"
 
 #include "Core/CharmDataModel.h"
+#include "Core/CharmDataModelSnapshot.h"
+#include "Core/DurationTable.h"
 #include "Core/Event.h"
 #include "Core/Task.h"
 
@@ -34,40 +36,43 @@ WeeklySummary::WeeklySummary()
 {
 }
 
-QVector<WeeklySummary> WeeklySummary::summariesForTimespan(CharmDataModel *dataModel,
-                                                           const TimeSpan &timespan)
+// the model and snapshots provide the same read access:
+template<typename DataModel>
+static QVector<WeeklySummary> summariesFor(const DataModel *dataModel, const TimeSpan &timespan)
 {
-    const EventIdList eventIds = dataModel->eventsThatStartInTimeFrame(timespan);
-    // prepare a list of unique task ids used within the time span:
-    TaskIdList taskIds, uniqueTaskIds; // the list of tasks to show
-    EventList events;
-    Q_FOREACH (EventId id, eventIds) {
-        Event event = dataModel->eventForId(id);
-        events << event;
-        taskIds << event.taskId();
-    }
-    std::sort(taskIds.begin(), taskIds.end());
-    std::unique_copy(taskIds.begin(), taskIds.end(), std::back_inserter(uniqueTaskIds));
-    Q_ASSERT(events.size() == eventIds.size());
+    // the tasks with events within the time span, sorted by id:
+    const auto &durations = dataModel->durations();
+    const TaskIdList taskIds = durations.tasksInTimeFrame(timespan.first, timespan.second);
     // retrieve task information
-    QVector<WeeklySummary> summaries(uniqueTaskIds.size());
-    for (int i = 0; i < uniqueTaskIds.size(); ++i) {
-        summaries[i].task = uniqueTaskIds.at(i);
-        const Task &task = dataModel->getTask(uniqueTaskIds[i]);
+    QVector<WeeklySummary> summaries(taskIds.size());
+    for (int i = 0; i < taskIds.size(); ++i) {
+        summaries[i].task = taskIds.at(i);
+        const Task &task = dataModel->getTask(taskIds[i]);
         summaries[i].taskname = dataModel->fullTaskName(task);
     }
-    // now add the times to the tasks:
-    Q_FOREACH (const Event &event, events) {
-        // find the index for this event:
-        auto it = std::find(uniqueTaskIds.begin(), uniqueTaskIds.end(), event.taskId());
-        if (it != uniqueTaskIds.end()) {
-            const int index = std::distance(uniqueTaskIds.begin(), it);
-            Q_ASSERT(index >= 0 && index < summaries.size());
-            const int dayOfWeek = event.startDateTime().date().dayOfWeek() - 1;
-            Q_ASSERT(dayOfWeek >= 0 && dayOfWeek < 7);
-            summaries[index].durations[dayOfWeek] += event.duration();
+    // now add the times of every day to the tasks:
+    for (QDate day = timespan.first; day < timespan.second; day = day.addDays(1)) {
+        const int dayOfWeek = day.dayOfWeek() - 1;
+        Q_ASSERT(dayOfWeek >= 0 && dayOfWeek < 7);
+        for (const auto &entry : durations.entriesOn(day)) {
+            const auto it = std::lower_bound(taskIds.begin(), taskIds.end(), entry.first);
+            Q_ASSERT(it != taskIds.end() && *it == entry.first);
+            const int index = std::distance(taskIds.begin(), it);
+            summaries[index].durations[dayOfWeek] += entry.second.duration;
         }
     }
 
     return summaries;
 }
+
+QVector<WeeklySummary> WeeklySummary::summariesForTimespan(CharmDataModel *dataModel,
+                                                           const TimeSpan &timespan)
+{
+    return summariesFor(dataModel, timespan);
+}
+
+QVector<WeeklySummary> WeeklySummary::summariesForTimespan(const CharmDataModelSnapshot &snapshot,
+                                                           const TimeSpan &timespan)
+{
+    return summariesFor(&snapshot, timespan);
+}
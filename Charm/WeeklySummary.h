@@ -31,12 +31,16 @@
 #include "Core/TimeSpans.h"
 
 class CharmDataModel;
+class CharmDataModelSnapshot;
 
 class WeeklySummary
 {
 public:
     static QVector<WeeklySummary> summariesForTimespan(CharmDataModel *dataModel,
                                                        const TimeSpan &timespan);
+    // does not access the model, can be used in a worker thread:
+    static QVector<WeeklySummary> summariesForTimespan(const CharmDataModelSnapshot &snapshot,
+                                                       const TimeSpan &timespan);
 
     WeeklySummary();
 
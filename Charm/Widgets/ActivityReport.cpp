@@ -34,11 +34,14 @@
 #include <QDomDocument>
 #include <QDomElement>
 #include <QFile>
+#include <QHash>
 #include <QPushButton>
 #include <QTimer>
 #include <QtAlgorithms>
 #include <QUrl>
 
+#include <algorithm>
+
 #include "ui_ActivityReportConfigurationDialog.h"
 
 ActivityReportConfigurationDialog::ActivityReportConfigurationDialog(QWidget *parent)
@@ -256,13 +259,16 @@ void ActivityReport::setReportProperties(
 void ActivityReport::slotUpdate()
 {
     // retrieve matching events:
-    EventIdList matchingEvents = DATAMODEL->eventsThatStartInTimeFrame(m_properties.start,
-                                                                       m_properties.end);
-
-    if (!m_properties.rootTasks.isEmpty()) {
+    DATAMODEL->requireEvents(m_properties.start, m_properties.end);
+    EventIdList matchingEvents;
+    if (m_properties.rootTasks.isEmpty()) {
+        matchingEvents = DATAMODEL->eventsThatStartInTimeFrame(m_properties.start,
+                                                               m_properties.end);
+    } else {
+        // only the events of the selected subtrees are visited:
         QSet<EventId> filteredEvents;
         Q_FOREACH (TaskId include, m_properties.rootTasks) {
-            auto list = Charm::filteredBySubtree(matchingEvents, include);
+            auto list = DATAMODEL->eventsInSubtree(include, m_properties.start, m_properties.end);
             filteredEvents |= QSet<EventId>(list.begin(), list.end());
         }
 
@@ -285,15 +291,42 @@ void ActivityReport::slotUpdate()
     }
 
     // filter unproductive events:
-    Q_FOREACH (TaskId exclude, m_properties.rootExcludeTasks)
-        matchingEvents = Charm::filteredBySubtree(matchingEvents, exclude, true);
+    if (!m_properties.rootExcludeTasks.isEmpty()) {
+        QSet<EventId> excludedEvents;
+        Q_FOREACH (TaskId exclude, m_properties.rootExcludeTasks) {
+            auto list = DATAMODEL->eventsInSubtree(exclude, m_properties.start, m_properties.end);
+            excludedEvents |= QSet<EventId>(list.begin(), list.end());
+        }
+        matchingEvents.erase(std::remove_if(matchingEvents.begin(), matchingEvents.end(),
+                                            [&excludedEvents](EventId id) {
+            return excludedEvents.contains(id);
+        }), matchingEvents.end());
+    }
 
-    // calculate total:
+    // calculate total, from the entries per task and day of the duration table:
+    auto isInSubtree = [](TaskId task, TaskId parent) {
+        return task == parent || DATAMODEL->isParentOf(parent, task);
+    };
+    QHash<TaskId, bool> reportedTasks;
+    auto isReported = [&](TaskId task) {
+        auto it = reportedTasks.find(task);
+        if (it == reportedTasks.end()) {
+            bool reported = m_properties.rootTasks.isEmpty();
+            Q_FOREACH (TaskId include, m_properties.rootTasks)
+                reported = reported || isInSubtree(task, include);
+            Q_FOREACH (TaskId exclude, m_properties.rootExcludeTasks)
+                reported = reported && !isInSubtree(task, exclude);
+            it = reportedTasks.insert(task, reported);
+        }
+        return it.value();
+    };
+    const DurationTable &durations = DATAMODEL->durations();
     int totalSeconds = 0;
-    Q_FOREACH (EventId id, matchingEvents) {
-        const Event &event = DATAMODEL->eventForId(id);
-        Q_ASSERT(event.isValid());
-        totalSeconds += event.duration();
+    for (QDate day = m_properties.start; day < m_properties.end; day = day.addDays(1)) {
+        for (const auto &entry : durations.entriesOn(day)) {
+            if (isReported(entry.first))
+                totalSeconds += entry.second.duration;
+        }
     }
 
     // which TimeSpan type
@@ -358,8 +358,8 @@ void EventView::timeFrameChanged(int index)
     if (m_comboBox->count() == 0) return;
     if (!m_model) return;
     if (index >= 0 && index < m_timeSpans.size()) {
-        m_model->setFilterStartDate(m_timeSpans[index].timespan.first);
-        m_model->setFilterEndDate(m_timeSpans[index].timespan.second);
+        m_model->setFilterTimeSpan(m_timeSpans[index].timespan.first,
+                                   m_timeSpans[index].timespan.second);
     } else {
         Q_ASSERT(false);
     }
@@ -440,6 +440,9 @@ void EventView::slotFindAndReplace()
     if (findAndReplace.exec() != QDialog::Accepted)
         return;
 
+    // the commands are executed synchronously, group the changes so that the
+    // views update once:
+    const CharmDataModel::Batch batch(MODEL.charmDataModel());
     QList<Event> events = findAndReplace.modifiedEvents();
     for (int i = 0; i < events.count(); ++i)
         slotEventChangesCompleted(events[i]);
@@ -75,8 +75,7 @@ FindAndReplaceEventsDialog::FindAndReplaceEventsDialog(QWidget *parent)
 
     m_model.reset(new EventModelFilter(DATAMODEL));
     m_ui->findAndReplaceLV->setModel(m_model.data());
-    m_model->setFilterStartDate(m_timeSpan.first);
-    m_model->setFilterEndDate(m_timeSpan.second);
+    m_model->setFilterTimeSpan(m_timeSpan.first, m_timeSpan.second);
 
     auto delegate = new EventEditorDelegate(m_model.data(), m_ui->findAndReplaceLV);
     m_ui->findAndReplaceLV->setItemDelegate(delegate);
@@ -88,7 +87,7 @@ FindAndReplaceEventsDialog::~FindAndReplaceEventsDialog()
 
 void FindAndReplaceEventsDialog::searchProjectCode()
 {
-    m_foundEvents = m_model->events();
+    m_foundEvents = m_model->eventIds();
 }
 
 void FindAndReplaceEventsDialog::slotReplaceProjectCode()
@@ -96,7 +95,7 @@ void FindAndReplaceEventsDialog::slotReplaceProjectCode()
     const QList<Event> events = m_model->events();
 
     for (int i = 0; i < events.count(); ++i) {
-        if (m_foundEvents.contains(events[i])) {
+        if (m_foundEvents.contains(events[i].id())) {
             Event event = events[i];
             event.setTaskId(m_taskToReplaceWith);
             m_modifiedEvents << event;
@@ -115,9 +114,8 @@ void FindAndReplaceEventsDialog::slotTimeSpansChanged()
 {
     m_timeSpan.first = m_ui->dateEditStart->date();
     m_timeSpan.second = m_ui->dateEditEnd->date();
-    m_model->setFilterStartDate(m_timeSpan.first);
     // add a day as the timespan logic in charm excludes events on the end date.
-    m_model->setFilterEndDate(m_timeSpan.second.addDays(1));
+    m_model->setFilterTimeSpan(m_timeSpan.first, m_timeSpan.second.addDays(1));
     if (m_taskToSearch > 0)
         searchProjectCode();
 }
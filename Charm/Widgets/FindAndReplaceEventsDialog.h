@@ -26,7 +26,9 @@
 
 #include <QDialog>
 #include <QScopedPointer>
+#include <QSet>
 
+#include "Core/Event.h"
 #include "Core/Task.h"
 #include <Core/TimeSpans.h>
 
@@ -70,7 +72,7 @@ private:
     TimeSpan m_timeSpan;
     QPushButton *m_replace;
     QPushButton *m_cancel;
-    QList<Event> m_foundEvents;
+    QSet<EventId> m_foundEvents;
     QList<Event> m_modifiedEvents;
     QScopedPointer<EventModelFilter> m_model;
     QScopedPointer<Ui::FindAndReplaceEventsDialog> m_ui;
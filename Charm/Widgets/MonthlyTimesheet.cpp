@@ -158,25 +158,23 @@ static QDomElement addTblCell(QDomElement &toRow, const QString &text)
 void MonthlyTimeSheetReport::update()
 {
     // this creates the time sheet
-    // retrieve matching events:
-    const EventIdList matchingEvents
-        = DATAMODEL->eventsThatStartInTimeFrame(startDate(), endDate());
-
     m_secondsMap.clear();
+    DATAMODEL->requireEvents(startDate(), endDate());
 
     // for every task, make a vector that includes a number of seconds
     // for every week of a month ( int seconds[m_numberOfWeeks]), and store those in
-    // a map by their task id
-    Q_FOREACH (EventId id, matchingEvents) {
-        const Event &event = DATAMODEL->eventForId(id);
-        QVector<int> seconds(m_numberOfWeeks);
-        if (m_secondsMap.contains(event.taskId()))
-            seconds = m_secondsMap.value(event.taskId());
-        // what week of the month is the event (normalized to vector indexes):
-        const int weekOfMonth = Charm::weekDifference(startDate(), event.startDateTime().date());
-        seconds[weekOfMonth] += event.duration();
-        // store in minute map:
-        m_secondsMap[event.taskId()] = seconds;
+    // a map by their task id. The seconds per day are looked up in the
+    // duration table of the model:
+    const DurationTable &durations = DATAMODEL->durations();
+    for (QDate day = startDate(); day < endDate(); day = day.addDays(1)) {
+        // what week of the month is it (normalized to vector indexes):
+        const int weekOfMonth = Charm::weekDifference(startDate(), day);
+        for (const auto &entry : durations.entriesOn(day)) {
+            QVector<int> &seconds = m_secondsMap[entry.first];
+            if (seconds.isEmpty())
+                seconds.resize(m_numberOfWeeks);
+            seconds[weekOfMonth] += entry.second.duration;
+        }
     }
     // now the reporting:
     // headline first:
@@ -203,7 +203,7 @@ void SelectTaskDialog::slotFilterTextChanged(const QString &text)
     filtertext.replace(QLatin1Char(' '), QLatin1Char('*'));
 
     Charm::saveExpandStates(m_ui->treeView, &m_expansionStates);
-    m_proxy.setFilterWildcard(filtertext);
+    m_proxy.setFilterText(filtertext);
     if (!filtertext.isEmpty()) {
         m_ui->treeView->expandAll();
     } else {
@@ -369,8 +369,8 @@ void TasksView::slotFiltertextChanged(const QString &filtertextRaw)
     filtertext.replace(QLatin1Char(' '), QLatin1Char('*'));
 
     saveGuiState();
-    filter->setFilterWildcard(filtertext);
     filter->setFilterRole(TasksViewRole_Filter);
+    filter->setFilterText(filtertext);
     if (!filtertextRaw.isEmpty()) {
         m_treeView->expandAll();
     } else {
@@ -138,7 +138,8 @@ void TimeTrackingTaskSelector::populate(const QVector<WeeklySummary> &summaries)
 
     m_menu->clear(); // this doesn't delete the actions yet, since they are in the systray as well
 
-    const TaskIdList interestingTasksToAdd = DATAMODEL->mostRecentlyUsedTasks();
+    const TaskIdList interestingTasksToAdd
+        = DATAMODEL->mostRecentlyUsedTasks(CONFIGURATION.numberOfTaskSelectorEntries);
 
     const int maxEntries = qMin(interestingTasksToAdd.size(),
                                 CONFIGURATION.numberOfTaskSelectorEntries);
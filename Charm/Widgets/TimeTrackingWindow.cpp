@@ -217,6 +217,11 @@ void TimeTrackingWindow::eventModified(EventId, Event)
     slotSelectTasksToShow();
 }
 
+void TimeTrackingWindow::eventsModified(const EventIdList &)
+{
+    slotSelectTasksToShow();
+}
+
 void TimeTrackingWindow::eventAboutToBeDeleted(EventId)
 {
 }
@@ -812,6 +817,7 @@ void TimeTrackingWindow::uploadStagedTimesheet()
         timesheet.setWeekNumber(weekNumber);
         timesheet.setIncludeTaskList(false);
 
+        DATAMODEL->requireEvents(weekStart, yesterday);
         const auto matchingEventIds = DATAMODEL->eventsThatStartInTimeFrame(weekStart, yesterday);
         EventList events;
         events.reserve(matchingEventIds.size());
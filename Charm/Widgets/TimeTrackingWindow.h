@@ -74,6 +74,7 @@ public:
     void eventAboutToBeAdded(EventId id) override;
     void eventAdded(EventId id) override;
     void eventModified(EventId id, Event discardedEvent) override;
+    void eventsModified(const EventIdList &ids) override;
     void eventAboutToBeDeleted(EventId id) override;
     void eventDeleted(EventId id) override;
     void eventActivated(EventId id) override;
@@ -326,26 +326,24 @@ QString WeeklyTimeSheetReport::suggestedFileName() const
 
 void WeeklyTimeSheetReport::update()
 {   // this creates the time sheet
-    // retrieve matching events:
-    const EventIdList matchingEvents
-        = DATAMODEL->eventsThatStartInTimeFrame(startDate(), endDate());
-
     m_secondsMap.clear();
+    DATAMODEL->requireEvents(startDate(), endDate());
 
     // for every task, make a vector that includes a number of seconds
     // for every day of the week ( int seconds[7]), and store those in
-    // a map by their task id
-    Q_FOREACH (EventId id, matchingEvents) {
-        const Event &event = DATAMODEL->eventForId(id);
-        QVector<int> seconds(DaysInWeek);
-        if (m_secondsMap.contains(event.taskId()))
-            seconds = m_secondsMap.value(event.taskId());
-        // what day in the week is the event (normalized to vector indexes):
-        int dayOfWeek = event.startDateTime().date().dayOfWeek() - 1;
+    // a map by their task id. The seconds per day are looked up in the
+    // duration table of the model:
+    const DurationTable &durations = DATAMODEL->durations();
+    for (QDate day = startDate(); day < endDate(); day = day.addDays(1)) {
+        // what day in the week is it (normalized to vector indexes):
+        const int dayOfWeek = day.dayOfWeek() - 1;
         Q_ASSERT(dayOfWeek >= 0 && dayOfWeek < DaysInWeek);
-        seconds[dayOfWeek] += event.duration();
-        // store in minute map:
-        m_secondsMap[event.taskId()] = seconds;
+        for (const auto &entry : durations.entriesOn(day)) {
+            QVector<int> &seconds = m_secondsMap[entry.first];
+            if (seconds.isEmpty())
+                seconds.resize(DaysInWeek);
+            seconds[dayOfWeek] += entry.second.duration;
+        }
     }
     // now the reporting:
     // headline first:
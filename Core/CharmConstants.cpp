@@ -68,6 +68,7 @@ const QString MetaKey_Key_ToolButtonStyle = QStringLiteral("ToolButtonStyle");
 const QString MetaKey_Key_ShowStatusBar = QStringLiteral("ShowStatusBar");
 const QString MetaKey_Key_EnableCommandInterface = QStringLiteral("EnableCommandInterface");
 const QString MetaKey_Key_NumberOfTaskSelectorEntries = QStringLiteral("NumberOfTaskSelectorEntries");
+const QString MetaKey_Key_EventLoadingWindow = QStringLiteral("EventLoadingWindow");
 
 const QString TrueString(QStringLiteral("true"));
 const QString FalseString(QStringLiteral("false"));
@@ -87,6 +88,12 @@ void connectControllerAndModel(Controller *controller, CharmDataModel *model)
                      model, SLOT(deleteEvent(Event)));
     QObject::connect(controller, SIGNAL(allEvents(EventList)),
                      model, SLOT(setAllEvents(EventList)));
+    QObject::connect(controller, SIGNAL(recentEvents(EventList,QDate)),
+                     model, SLOT(setRecentEvents(EventList,QDate)));
+    QObject::connect(model, SIGNAL(eventsRequested(QDate,QDate)),
+                     controller, SLOT(provideEventsInRange(QDate,QDate)));
+    QObject::connect(controller, SIGNAL(eventsInRange(EventList)),
+                     model, SLOT(addLoadedEvents(EventList)));
     QObject::connect(controller, SIGNAL(definedTasks(TaskList)),
                      model, SLOT(setAllTasks(TaskList)));
     QObject::connect(controller, SIGNAL(taskAdded(Task)),
@@ -95,6 +102,10 @@ void connectControllerAndModel(Controller *controller, CharmDataModel *model)
                      model, SLOT(modifyTask(Task)));
     QObject::connect(controller, SIGNAL(taskDeleted(Task)),
                      model, SLOT(deleteTask(Task)));
+    QObject::connect(controller, SIGNAL(batchStarted()),
+                     model, SLOT(beginBatch()));
+    QObject::connect(controller, SIGNAL(batchFinished()),
+                     model, SLOT(endBatch()));
 }
 
 static QString formatDecimal(double d)
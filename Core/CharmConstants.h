@@ -36,7 +36,8 @@
 #define CHARM_DATABASE_VERSION_BEFORE_TASK_EXPIRY 2
 #define CHARM_DATABASE_VERSION_BEFORE_TRACKABLE 3
 #define CHARM_DATABASE_VERSION_BEFORE_COMMENT 4
-#define CHARM_DATABASE_VERSION 5
+#define CHARM_DATABASE_VERSION_BEFORE_INDEXES 5
+#define CHARM_DATABASE_VERSION 6
 #define REQUIRED_CHARM_DATABASE_VERSION CHARM_DATABASE_VERSION
 // FIXME this may have to go into some plugin configuration later:
 // FIXME also, we may need some verbose descriptors for configuration
@@ -75,6 +76,7 @@ extern const QString MetaKey_Key_ToolButtonStyle;
 extern const QString MetaKey_Key_ShowStatusBar;
 extern const QString MetaKey_Key_EnableCommandInterface;
 extern const QString MetaKey_Key_NumberOfTaskSelectorEntries;
+extern const QString MetaKey_Key_EventLoadingWindow;
 
 extern const QString TrueString;
 extern const QString FalseString;
@@ -38,9 +38,11 @@
 
 #include <algorithm>
 #include <functional>
+#include <limits>
 #include <queue>
 #include <unordered_map>
 #include <set>
+#include <vector>
 
 CharmDataModel::CharmDataModel()
     : QObject()
@@ -83,12 +85,11 @@ void CharmDataModel::setAllTasks(const TaskList &tasks)
 {
     clearTasks();
 
-    Q_ASSERT(Task::checkForTreeness(tasks));
-    Q_ASSERT(Task::checkForUniqueTaskIds(tasks));
+    Q_ASSERT(Task::validateTaskList(tasks) == Task::ValidTaskList);
 
     // fill the tasks into the map to TaskTreeItems
     for (int i = 0; i < tasks.size(); ++i) {
-        const TaskTreeItem item(tasks[i], &m_rootItem);
+        const TaskTreeItem item(tasks[i]);
         Q_ASSERT(!taskExists(tasks[i].id()));      // the tasks form a tree and have unique task ids
         m_tasks[ tasks[i].id() ] = item;
     }
@@ -102,12 +103,19 @@ void CharmDataModel::setAllTasks(const TaskList &tasks)
 
     // store task id length:
     determineTaskPaddingLength();
+    invalidateSubtreeNumbering();
 
     m_nameCache.setAllTasks(tasks);
+    m_fullTaskNames.clear();
+    markTasksChanged(Change::TasksReset, 0);
 
     // notify adapters of changes
-    for_each(m_adapters.begin(), m_adapters.end(),
-             std::mem_fun(&CharmDataModelAdapterInterface::resetTasks));
+    if (m_batchDepth > 0) {
+        m_pendingChanges.resetTasks = true;
+    } else {
+        for_each(m_adapters.begin(), m_adapters.end(),
+                 std::mem_fun(&CharmDataModelAdapterInterface::resetTasks));
+    }
 
     emit resetGUIState();
 }
@@ -120,9 +128,13 @@ void CharmDataModel::addTask(const Task &task)
     if (task.isValid() && !taskExists(task.id())) {
         const TaskTreeItem &parent = taskTreeItem(task.parent());
 
-        Q_FOREACH (auto adapter, m_adapters)
-            adapter->taskAboutToBeAdded(parent.task().id(),
-                                        parent.childCount());
+        if (m_batchDepth > 0) {
+            m_pendingChanges.resetTasks = true;
+        } else {
+            Q_FOREACH (auto adapter, m_adapters)
+                adapter->taskAboutToBeAdded(parent.task().id(),
+                                            parent.childCount());
+        }
 
         const TaskTreeItem item(task);
         m_tasks[ task.id() ] = item;
@@ -134,10 +146,14 @@ void CharmDataModel::addTask(const Task &task)
         it->second.makeChildOf(parentItem(task));
 
         determineTaskPaddingLength();
+        invalidateSubtreeNumbering();
+        markTasksChanged(Change::TaskAdded, task.id());
 //        regenerateSmartNames();
 
-        Q_FOREACH (auto adapter, m_adapters)
-            adapter->taskAdded(task.id());
+        if (m_batchDepth == 0) {
+            Q_FOREACH (auto adapter, m_adapters)
+                adapter->taskAdded(task.id());
+        }
     } else {
         qCritical() << "CharmDataModel::addTask: duplicate task id"
                     << task.id() << "ignored. THIS IS A BUG";
@@ -154,17 +170,31 @@ void CharmDataModel::modifyTask(const Task &task)
         return;
     const TaskId oldParentId = it->second.task().parent();
     const bool parentChanged = task.parent() != oldParentId;
+    if (parentChanged || task.name() != it->second.task().name())
+        invalidateFullTaskNames(task.id());
 
     if (parentChanged) {
-        Q_FOREACH (auto adapter, m_adapters)
-            adapter->taskParentChanged(task.id(), oldParentId, task.parent());
+        if (m_batchDepth == 0) {
+            Q_FOREACH (auto adapter, m_adapters)
+                adapter->taskParentChanged(task.id(), oldParentId, task.parent());
+        }
         m_tasks[ task.id() ].makeChildOf(parentItem(task));
     }
 
     m_tasks[ task.id() ].task() = task;
     m_nameCache.modifyTask(task);
-
-    if (parentChanged) {
+    markTasksChanged(Change::TaskModified, task.id());
+    if (parentChanged)
+        invalidateSubtreeNumbering();
+
+    if (m_batchDepth > 0) {
+        if (parentChanged)
+            m_pendingChanges.resetTasks = true;
+        else if (!m_pendingChanges.modifiedTaskIds.contains(task.id())) {
+            m_pendingChanges.modifiedTaskIds.insert(task.id());
+            m_pendingChanges.modifiedTasks.append(task.id());
+        }
+    } else if (parentChanged) {
         Q_FOREACH (auto adapter, m_adapters)
             adapter->resetTasks();
     } else {
@@ -181,8 +211,12 @@ void CharmDataModel::deleteTask(const Task &task)
                Q_FUNC_INFO,
                "Cannot delete a task that has children");
 
-    Q_FOREACH (auto adapter, m_adapters)
-        adapter->taskAboutToBeDeleted(task.id());
+    if (m_batchDepth > 0) {
+        m_pendingChanges.resetTasks = true;
+    } else {
+        Q_FOREACH (auto adapter, m_adapters)
+            adapter->taskAboutToBeDeleted(task.id());
+    }
 
     const auto it = m_tasks.find(task.id());
     if (it != m_tasks.end()) {
@@ -190,42 +224,169 @@ void CharmDataModel::deleteTask(const Task &task)
         it->second.makeChildOf(tmpParent);
         m_tasks.erase(it);
     }
+    markTasksChanged(Change::TaskDeleted, task.id());
 
     m_nameCache.deleteTask(task);
+    m_fullTaskNames.erase(task.id());
+    invalidateSubtreeNumbering();
 
-    Q_FOREACH (auto adapter, m_adapters)
-        adapter->taskDeleted(task.id());
+    if (m_batchDepth == 0) {
+        Q_FOREACH (auto adapter, m_adapters)
+            adapter->taskDeleted(task.id());
+    }
 }
 
 void CharmDataModel::clearTasks()
 {
-    // to clear the task list, all tasks have first to be changed to be children of the root item:
-    for (TaskTreeItem::Map::iterator it = m_tasks.begin(); it != m_tasks.end(); ++it)
+    // to clear the task list, all tasks have first to be changed to be children of the root item.
+    // Children are usually sorted by task id, going backwards always removes the last child,
+    // and the items are destroyed from the last row on, so no siblings need to be renumbered:
+    for (TaskTreeItem::Map::reverse_iterator it = m_tasks.rbegin(); it != m_tasks.rend(); ++it)
         it->second.makeChildOf(m_rootItem);
-
-    m_tasks.clear();
+    for (int row = m_rootItem.childCount() - 1; row >= 0; --row) {
+        const TaskId id = m_rootItem.child(row).task().id();
+        m_tasks.erase(id);
+    }
+    Q_ASSERT(m_tasks.empty());
     m_nameCache.clearTasks();
+    m_fullTaskNames.clear();
     m_rootItem = TaskTreeItem();
+    invalidateSubtreeNumbering();
+    markTasksChanged(Change::TasksReset, 0);
 
-    Q_FOREACH (auto adapter, m_adapters)
-        adapter->resetTasks();
+    if (m_batchDepth > 0) {
+        m_pendingChanges.resetTasks = true;
+    } else {
+        Q_FOREACH (auto adapter, m_adapters)
+            adapter->resetTasks();
+    }
 }
 
 void CharmDataModel::setAllEvents(const EventList &events)
 {
+    m_eventWindowStart = QDate();
+    m_loadedMonths.clear();
     m_events.clear();
+    m_events.reserve(events.size());
+    clearEventIndexes();
 
     for (int i = 0; i < events.size(); ++i) {
         if (!eventExists(events[i].id())) {
-            m_events[ events[i].id() ] = events[i];
+            m_events.insert(events[i]);
+            indexEvent(events[i]);
         } else {
             qCritical() << "CharmDataModel::addTask: duplicate task id"
                         << m_tasks[i].task().id() << "ignored. THIS IS A BUG";
         }
     }
+    rebuildActiveEventIndex();
+    markEventsChanged(Change::EventsReset, 0);
 
-    Q_FOREACH (auto adapter, m_adapters)
-        adapter->resetEvents();
+    if (m_batchDepth > 0) {
+        m_pendingChanges.resetEvents = true;
+    } else {
+        Q_FOREACH (auto adapter, m_adapters)
+            adapter->resetEvents();
+    }
+}
+
+void CharmDataModel::setRecentEvents(const EventList &events, const QDate &windowStart)
+{
+    setAllEvents(events);
+    m_eventWindowStart = windowStart;
+}
+
+void CharmDataModel::addLoadedEvents(const EventList &events)
+{
+    const Batch batch(this);
+    Q_FOREACH (const Event &event, events) {
+        if (!eventExists(event.id()))
+            addEvent(event);
+    }
+}
+
+// months are numbered continuously, so that they can be compared:
+static int monthNumber(const QDate &date)
+{
+    return date.year() * 12 + date.month() - 1;
+}
+
+static QDate firstDayOfMonth(int month)
+{
+    return QDate(month / 12, month % 12 + 1, 1);
+}
+
+void CharmDataModel::requireEvents(const QDate &start, const QDate &end)
+{
+    if (!m_eventWindowStart.isValid())
+        return;   // all events are loaded
+
+    const QDate last = end.isValid() ? qMin(end, m_eventWindowStart) : m_eventWindowStart;
+    if (start.isValid() && start >= last)
+        return;
+
+    // the number of months kept loaded:
+    static const int MaxLoadedMonths = 12;
+    if (!start.isValid() || monthNumber(last.addDays(-1)) - monthNumber(start) >= MaxLoadedMonths) {
+        // load everything that has not been loaded so far, nothing will be unloaded afterwards:
+        const QDate windowStart = m_eventWindowStart;
+        m_eventWindowStart = QDate();
+        m_loadedMonths.clear();
+        emit eventsRequested(QDate(), windowStart);
+        return;
+    }
+
+    // load the missing months, and mark the others as recently used:
+    for (int month = monthNumber(start); firstDayOfMonth(month) < last; ++month) {
+        const auto it = std::find(m_loadedMonths.begin(), m_loadedMonths.end(), month);
+        if (it != m_loadedMonths.end()) {
+            m_loadedMonths.splice(m_loadedMonths.begin(), m_loadedMonths, it);
+        } else {
+            m_loadedMonths.push_front(month);
+            emit eventsRequested(firstDayOfMonth(month),
+                                 qMin(firstDayOfMonth(month + 1), m_eventWindowStart));
+        }
+    }
+
+    while (m_loadedMonths.size() > static_cast<std::size_t>(MaxLoadedMonths)) {
+        unloadMonth(m_loadedMonths.back());
+        m_loadedMonths.pop_back();
+    }
+}
+
+QDate CharmDataModel::eventWindowStart() const
+{
+    return m_eventWindowStart;
+}
+
+void CharmDataModel::unloadMonth(int month)
+{
+    const qint64 startSecs = QDateTime(firstDayOfMonth(month), QTime(0, 0)).toSecsSinceEpoch();
+    const qint64 endSecs = QDateTime(qMin(firstDayOfMonth(month + 1), m_eventWindowStart),
+                                     QTime(0, 0)).toSecsSinceEpoch();
+    EventList events;
+    const auto first = m_eventsByStart.lower_bound(EventStartKey(startSecs, std::numeric_limits<EventId>::min()));
+    const auto last = m_eventsByStart.lower_bound(EventStartKey(endSecs, std::numeric_limits<EventId>::min()));
+    for (auto it = first; it != last; ++it) {
+        if (!isEventActive(it->second))
+            events << eventForId(it->second);
+    }
+
+    // the events still exist in the storage, unloading them is not a deletion:
+    const Batch batch(this);
+    Q_FOREACH (const Event &event, events)
+        removeEvent(event, Change::EventUnloaded);
+}
+
+bool CharmDataModel::isEventLoaded(const Event &event) const
+{
+    if (!m_eventWindowStart.isValid())
+        return true;   // all events are loaded
+    const QDate day = event.startDateTime().date();
+    if (!day.isValid() || day >= m_eventWindowStart)
+        return true;
+    return std::find(m_loadedMonths.begin(), m_loadedMonths.end(), monthNumber(day))
+           != m_loadedMonths.end();
 }
 
 void CharmDataModel::addEvent(const Event &event)
@@ -233,10 +394,20 @@ void CharmDataModel::addEvent(const Event &event)
     Q_ASSERT_X(!eventExists(event.id()), Q_FUNC_INFO,
                "New event must have a unique id");
 
+    if (m_batchDepth > 0) {
+        m_pendingChanges.resetEvents = true;
+        m_events.insert(event);
+        indexEvent(event);
+        markEventsChanged(Change::EventAdded, event.id());
+        return;
+    }
+
     Q_FOREACH (auto adapter, m_adapters)
         adapter->eventAboutToBeAdded(event.id());
 
-    m_events[ event.id() ] = event;
+    m_events.insert(event);
+    indexEvent(event);
+    markEventsChanged(Change::EventAdded, event.id());
 
     Q_FOREACH (auto adapter, m_adapters)
         adapter->eventAdded(event.id());
@@ -244,12 +415,34 @@ void CharmDataModel::addEvent(const Event &event)
 
 void CharmDataModel::modifyEvent(const Event &newEvent)
 {
-    Q_ASSERT_X(eventExists(newEvent.id()), Q_FUNC_INFO,
-               "Event to modify has to exist");
+    if (!eventExists(newEvent.id())) {
+        // events older than the recent events may not be loaded, e.g. when an undo or
+        // the storage modifies an event of a month that has been unloaded:
+        Q_ASSERT_X(m_eventWindowStart.isValid(), Q_FUNC_INFO,
+                   "Event to modify has to exist");
+        if (isEventLoaded(newEvent))
+            addEvent(newEvent);
+        return;
+    }
 
     const Event oldEvent = eventForId(newEvent.id());
 
-    m_events[ newEvent.id() ] = newEvent;
+    unindexEvent(oldEvent);
+    m_events.insert(newEvent);
+    indexEvent(newEvent);
+    markEventsChanged(Change::EventModified, newEvent.id());
+    if (oldEvent.taskId() != newEvent.taskId() && isEventActive(newEvent.id())) {
+        removeActiveEvent(newEvent.id());
+        insertActiveEvent(newEvent);
+    }
+
+    if (m_batchDepth > 0) {
+        if (!m_pendingChanges.modifiedEventIds.contains(newEvent.id())) {
+            m_pendingChanges.modifiedEventIds.insert(newEvent.id());
+            m_pendingChanges.modifiedEvents.append(newEvent.id());
+        }
+        return;
+    }
 
     Q_FOREACH (auto adapter, m_adapters)
         adapter->eventModified(newEvent.id(), oldEvent);
@@ -257,28 +450,89 @@ void CharmDataModel::modifyEvent(const Event &newEvent)
 
 void CharmDataModel::deleteEvent(const Event &event)
 {
-    Q_ASSERT_X(eventExists(event.id()), Q_FUNC_INFO,
-               "Event to delete has to exist");
+    if (!eventExists(event.id())) {
+        // the event may belong to a month that is not loaded:
+        Q_ASSERT_X(m_eventWindowStart.isValid(), Q_FUNC_INFO,
+                   "Event to delete has to exist");
+        return;
+    }
+
+    removeEvent(event, Change::EventDeleted);
+}
+
+void CharmDataModel::removeEvent(const Event &event, Change::Kind kind)
+{
     Q_ASSERT_X(!m_activeEventIds.contains(event.id()), Q_FUNC_INFO,
                "Cannot delete an active event");
 
-    Q_FOREACH (auto adapter, m_adapters)
-        adapter->eventAboutToBeDeleted(event.id());
+    const bool notify = m_batchDepth == 0;
+    if (notify) {
+        Q_FOREACH (auto adapter, m_adapters)
+            adapter->eventAboutToBeDeleted(event.id());
+    } else {
+        m_pendingChanges.resetEvents = true;
+    }
 
-    const auto it = m_events.find(event.id());
-    if (it != m_events.end())
-        m_events.erase(it);
+    if (const Event *stored = m_events.find(event.id())) {
+        unindexEvent(*stored);
+        m_events.remove(event.id());
+        markEventsChanged(kind, event.id());
+    }
 
-    Q_FOREACH (auto adapter, m_adapters)
-        adapter->eventDeleted(event.id());
+    if (notify) {
+        Q_FOREACH (auto adapter, m_adapters)
+            adapter->eventDeleted(event.id());
+    }
 }
 
 void CharmDataModel::clearEvents()
 {
     m_events.clear();
+    clearEventIndexes();
+    rebuildActiveEventIndex();
+    markEventsChanged(Change::EventsReset, 0);
 
-    Q_FOREACH (auto adapter, m_adapters)
-        adapter->resetEvents();
+    if (m_batchDepth > 0) {
+        m_pendingChanges.resetEvents = true;
+    } else {
+        Q_FOREACH (auto adapter, m_adapters)
+            adapter->resetEvents();
+    }
+}
+
+void CharmDataModel::beginBatch()
+{
+    ++m_batchDepth;
+}
+
+void CharmDataModel::endBatch()
+{
+    Q_ASSERT_X(m_batchDepth > 0, Q_FUNC_INFO, "endBatch() without beginBatch()");
+    if (m_batchDepth == 0 || --m_batchDepth > 0)
+        return;
+
+    const PendingChanges changes = m_pendingChanges;
+    m_pendingChanges = PendingChanges();
+
+    if (changes.resetTasks) {
+        Q_FOREACH (auto adapter, m_adapters)
+            adapter->resetTasks();
+    } else {
+        Q_FOREACH (TaskId id, changes.modifiedTasks) {
+            if (!taskExists(id))
+                continue;
+            Q_FOREACH (auto adapter, m_adapters)
+                adapter->taskModified(id);
+        }
+    }
+
+    if (changes.resetEvents) {
+        Q_FOREACH (auto adapter, m_adapters)
+            adapter->resetEvents();
+    } else if (!changes.modifiedEvents.isEmpty()) {
+        Q_FOREACH (auto adapter, m_adapters)
+            adapter->eventsModified(changes.modifiedEvents);
+    }
 }
 
 const TaskTreeItem &CharmDataModel::taskTreeItem(TaskId id) const
@@ -314,20 +568,287 @@ Task &CharmDataModel::findTask(TaskId id)
 const Event &CharmDataModel::eventForId(EventId id) const
 {
     static const Event InvalidEvent;
-    EventMap::const_iterator it = m_events.find(id);
-    if (it != m_events.end()) {
-        return it->second;
+    const Event *event = m_events.find(id);
+    if (event) {
+        return *event;
     } else {
         return InvalidEvent;
     }
 }
 
-Event &CharmDataModel::findEvent(int id)
+const Event &CharmDataModel::findEvent(EventId id) const
 {
     // in this method, the event has to exist
-    const auto it = m_events.find(id);
-    Q_ASSERT(it != m_events.end());
-    return it->second;
+    const Event *event = m_events.find(id);
+    Q_ASSERT(event);
+    return *event;
+}
+
+void CharmDataModel::indexEvent(const Event &event)
+{
+    const EventStartKey key(event.startSecsSinceEpoch(), event.id());
+    if (key.first != Event::InvalidTime)
+        m_eventsByStart.insert(key);
+    unrankTask(event.taskId());
+    m_eventsByTask[event.taskId()].insert(key);
+    rankTask(event.taskId());
+    m_durations.addEvent(event);
+    addToSubtreeDurations(event, 1);
+    m_eventDurations.insert(event.duration());
+}
+
+void CharmDataModel::unindexEvent(const Event &event)
+{
+    const EventStartKey key(event.startSecsSinceEpoch(), event.id());
+    if (key.first != Event::InvalidTime)
+        m_eventsByStart.erase(key);
+    const auto it = m_eventsByTask.find(event.taskId());
+    if (it != m_eventsByTask.end()) {
+        unrankTask(event.taskId());
+        it->second.erase(key);
+        if (it->second.empty()) {
+            m_eventsByTask.erase(it);
+        } else {
+            rankTask(event.taskId());
+        }
+    }
+    m_durations.removeEvent(event);
+    addToSubtreeDurations(event, -1);
+    const auto duration = m_eventDurations.find(event.duration());
+    if (duration != m_eventDurations.end())
+        m_eventDurations.erase(duration);
+}
+
+void CharmDataModel::clearEventIndexes()
+{
+    m_eventsByStart.clear();
+    m_eventsByTask.clear();
+    m_mostFrequentlyUsed.clear();
+    m_mostRecentlyUsed.clear();
+    m_durations.clear();
+    m_subtreeDurations.clear();
+    m_subtreeDurationsValid = false;
+    m_eventDurations.clear();
+}
+
+void CharmDataModel::unrankTask(TaskId id)
+{
+    const auto it = m_eventsByTask.find(id);
+    if (id == 0 || it == m_eventsByTask.end() || it->second.empty())
+        return;
+    m_mostFrequentlyUsed.erase(TaskRankKey(static_cast<qint64>(it->second.size()), id));
+    m_mostRecentlyUsed.erase(TaskRankKey(it->second.rbegin()->first, id));
+}
+
+void CharmDataModel::rankTask(TaskId id)
+{
+    // events without a task are not taken into account:
+    const auto it = m_eventsByTask.find(id);
+    if (id == 0 || it == m_eventsByTask.end() || it->second.empty())
+        return;
+    m_mostFrequentlyUsed.insert(TaskRankKey(static_cast<qint64>(it->second.size()), id));
+    m_mostRecentlyUsed.insert(TaskRankKey(it->second.rbegin()->first, id));
+}
+
+TaskIdList CharmDataModel::topOfRanking(const TaskRanking &ranking, int count)
+{
+    const int size = static_cast<int>(ranking.size());
+    if (count < 0 || count > size)
+        count = size;
+
+    TaskIdList out;
+    out.reserve(count);
+    for (auto it = ranking.cbegin(); it != ranking.cend() && out.size() < count; ++it)
+        out << it->second;
+    return out;
+}
+
+void CharmDataModel::rebuildEventIndexes()
+{
+    clearEventIndexes();
+    for (const Event &event : m_events)
+        indexEvent(event);
+}
+
+quint64 CharmDataModel::generation() const
+{
+    return m_generation;
+}
+
+quint64 CharmDataModel::taskGeneration() const
+{
+    return m_taskGeneration;
+}
+
+quint64 CharmDataModel::eventGeneration() const
+{
+    return m_eventGeneration;
+}
+
+bool CharmDataModel::changesSince(quint64 generation, ChangeList *changes) const
+{
+    Q_ASSERT(changes);
+    changes->clear();
+    if (generation > m_generation)
+        return false;   // not a generation of this model
+    if (generation == m_generation)
+        return true;
+    // the entries have consecutive generations, ending with the current one:
+    const quint64 missing = m_generation - generation;
+    if (missing > m_changes.size())
+        return false;
+
+    changes->reserve(static_cast<int>(missing));
+    for (auto it = m_changes.end() - static_cast<std::ptrdiff_t>(missing); it != m_changes.end(); ++it)
+        changes->append(*it);
+    return true;
+}
+
+CharmDataModelSnapshot CharmDataModel::snapshot() const
+{
+    // the task data is only copied once after it has changed, all snapshots
+    // taken in between share it:
+    if (!m_taskSnapshot) {
+        auto data = std::make_shared<CharmDataModelSnapshot::TaskData>();
+        data->tasks.reserve(m_tasks.size());
+        for (const auto &entry : m_tasks) {
+            if (entry.second.task().isValid())
+                data->tasks.emplace(entry.first, entry.second.task());
+        }
+        m_taskSnapshot = data;
+    }
+    // only the event blocks holding changed events are rebuilt:
+    if (!m_eventSnapshot) {
+        m_eventSnapshot = CharmDataModelSnapshot::makeEventData(m_events);
+        m_eventsChangedSinceSnapshot.clear();
+    } else if (!m_eventsChangedSinceSnapshot.empty()) {
+        m_eventSnapshot = CharmDataModelSnapshot::updateEventData(*m_eventSnapshot, m_events,
+                                                                  m_eventsChangedSinceSnapshot);
+        m_eventsChangedSinceSnapshot.clear();
+    }
+
+    CharmDataModelSnapshot snapshot;
+    snapshot.m_taskData = m_taskSnapshot;
+    snapshot.m_eventData = m_eventSnapshot;
+    snapshot.m_activeEvents = m_activeEventIds;
+    snapshot.m_generation = m_generation;
+    return snapshot;
+}
+
+void CharmDataModel::recordChange(Change::Kind kind, int id)
+{
+    // the number of changes kept in the journal:
+    static const std::size_t MaxJournalSize = 1024;
+
+    ++m_generation;
+    // all event related kinds follow the task related ones:
+    if (kind >= Change::EventAdded)
+        m_eventGeneration = m_generation;
+    else
+        m_taskGeneration = m_generation;
+
+    const Change change = { m_generation, kind, id };
+    m_changes.push_back(change);
+    if (m_changes.size() > MaxJournalSize)
+        m_changes.pop_front();
+}
+
+void CharmDataModel::markTasksChanged(Change::Kind kind, TaskId id)
+{
+    recordChange(kind, id);
+    m_taskSnapshot.reset();
+}
+
+void CharmDataModel::markEventsChanged(Change::Kind kind, EventId id)
+{
+    recordChange(kind, id);
+    if (kind == Change::EventsReset) {
+        m_eventSnapshot.reset();
+        m_eventsChangedSinceSnapshot.clear();
+    } else if (m_eventSnapshot) {
+        m_eventsChangedSinceSnapshot.insert(id);
+    }
+}
+
+void CharmDataModel::invalidateSubtreeNumbering()
+{
+    m_subtreeNumberingValid = false;
+    m_subtreeNumbering.clear();
+    m_subtreeDurationsValid = false;
+    m_subtreeDurations.clear();
+}
+
+void CharmDataModel::updateSubtreeNumbering() const
+{
+    if (m_subtreeNumberingValid)
+        return;
+
+    m_subtreeNumbering.clear();
+    m_subtreeNumbering.reserve(m_tasks.size());
+    int counter = 0;
+    // iterative depth first traversal, the int is the next child to visit:
+    std::vector<std::pair<const TaskTreeItem *, int> > stack;
+    stack.emplace_back(&m_rootItem, 0);
+    while (!stack.empty()) {
+        const TaskTreeItem *item = stack.back().first;
+        const int row = stack.back().second;
+        if (row < item->childCount()) {
+            ++stack.back().second;
+            const TaskTreeItem &child = item->child(row);
+            m_subtreeNumbering[child.task().id()].enter = ++counter;
+            stack.emplace_back(&child, 0);
+        } else {
+            if (item != &m_rootItem)
+                m_subtreeNumbering[item->task().id()].leave = ++counter;
+            stack.pop_back();
+        }
+    }
+    m_subtreeNumberingValid = true;
+}
+
+void CharmDataModel::updateSubtreeDurations() const
+{
+    if (m_subtreeDurationsValid)
+        return;
+
+    // add the entries of every task to the task and all its parents:
+    m_subtreeDurations.clear();
+    for (const auto &day : m_durations.days()) {
+        for (const auto &entry : day.second) {
+            TaskId id = entry.first;
+            while (true) {
+                m_subtreeDurations.addEntry(id, day.first, entry.second);
+                const auto it = m_tasks.find(id);
+                if (it == m_tasks.end() || !it->second.isValid())
+                    break;
+                id = it->second.task().parent();
+                if (id == 0)
+                    break;
+            }
+        }
+    }
+    m_subtreeDurationsValid = true;
+}
+
+void CharmDataModel::addToSubtreeDurations(const Event &event, int sign)
+{
+    // the rollups are only maintained once they have been built:
+    if (!m_subtreeDurationsValid)
+        return;
+
+    TaskId id = event.taskId();
+    while (true) {
+        if (sign > 0)
+            m_subtreeDurations.addEvent(id, event);
+        else
+            m_subtreeDurations.removeEvent(id, event);
+        const auto it = m_tasks.find(id);
+        if (it == m_tasks.end() || !it->second.isValid())
+            break;
+        id = it->second.task().parent();
+        if (id == 0)
+            break;
+    }
 }
 
 bool CharmDataModel::activateEvent(const Event &activeEvent)
@@ -337,21 +858,20 @@ bool CharmDataModel::activateEvent(const Event &activeEvent)
         TaskId taskId = activeEvent.taskId();
 
         // this check may become obsolete:
-        for (int i = 0; i < m_activeEventIds.size(); ++i) {
-            if (m_activeEventIds[i] == activeEvent.id()) {
-                Q_ASSERT(!"inconsistency (event already active)!");
-                return false;
-            }
+        if (isEventActive(activeEvent.id())) {
+            Q_ASSERT(!"inconsistency (event already active)!");
+            return false;
+        }
 
-            const Event &e = eventForId(m_activeEventIds[i]);
-            if (e.taskId() == taskId) {
-                Q_ASSERT(!"inconsistency (event already active for task)!");
-                return false;
-            }
+        if (m_activeEventsByTask.count(taskId)) {
+            Q_ASSERT(!"inconsistency (event already active for task)!");
+            return false;
         }
     }
 
     m_activeEventIds << activeEvent.id();
+    insertActiveEvent(activeEvent);
+    recordChange(Change::EventActivated, activeEvent.id());
     Q_FOREACH (auto adapter, m_adapters)
         adapter->eventActivated(activeEvent.id());
     m_timer.start(10000);
@@ -387,34 +907,53 @@ bool CharmDataModel::taskExists(TaskId id)
 
 bool CharmDataModel::eventExists(EventId id)
 {
-    return m_events.find(id) != m_events.end();
+    return m_events.contains(id);
 }
 
 bool CharmDataModel::isTaskActive(TaskId id) const
 {
-    for (int i = 0; i < m_activeEventIds.size(); ++i) {
-        const Event &e = eventForId(m_activeEventIds[i]);
-        Q_ASSERT(e.isValid());
-        if (e.taskId() == id)
-            return true;
-    }
-
-    return false;
+    return m_activeEventsByTask.count(id) > 0;
 }
 
 const Event &CharmDataModel::activeEventFor(TaskId id) const
 {
     static Event InvalidEvent;
 
-    for (int i = 0; i < m_activeEventIds.size(); ++i) {
-        const Event &e = eventForId(m_activeEventIds[i]);
-        if (e.taskId() == id)
-            return e;
-    }
+    const auto it = m_activeEventsByTask.find(id);
+    if (it != m_activeEventsByTask.end())
+        return eventForId(it->second);
 
     return InvalidEvent;
 }
 
+void CharmDataModel::insertActiveEvent(const Event &event)
+{
+    m_activeEventsByTask[event.taskId()] = event.id();
+    m_activeEventTasks[event.id()] = event.taskId();
+}
+
+void CharmDataModel::removeActiveEvent(EventId id)
+{
+    const auto it = m_activeEventTasks.find(id);
+    if (it == m_activeEventTasks.end())
+        return;
+    const auto byTask = m_activeEventsByTask.find(it->second);
+    if (byTask != m_activeEventsByTask.end() && byTask->second == id)
+        m_activeEventsByTask.erase(byTask);
+    m_activeEventTasks.erase(it);
+}
+
+void CharmDataModel::rebuildActiveEventIndex()
+{
+    m_activeEventsByTask.clear();
+    m_activeEventTasks.clear();
+    Q_FOREACH (EventId id, m_activeEventIds) {
+        const TaskId taskId = eventForId(id).taskId();
+        m_activeEventsByTask[taskId] = id;
+        m_activeEventTasks[id] = taskId;
+    }
+}
+
 void CharmDataModel::startEventRequested(const Task &task)
 {
     // respect configuration:
@@ -435,20 +974,25 @@ void CharmDataModel::endEventRequested(const Task &task)
     EventId eventId = 0;
 
     // find the event in the list of active events and remove it:
-    for (int i = 0; i < m_activeEventIds.size(); ++i) {
-        if (eventForId(m_activeEventIds[i]).taskId() == task.id()) {
-            eventId = m_activeEventIds[i];
-            m_activeEventIds.removeAt(i);
-            Q_FOREACH (auto adapter, m_adapters)
-                adapter->eventDeactivated(eventId);
-            break;
-        }
+    const auto it = m_activeEventsByTask.find(task.id());
+    if (it != m_activeEventsByTask.end()) {
+        eventId = it->second;
+        m_activeEventIds.removeOne(eventId);
+        removeActiveEvent(eventId);
+        recordChange(Change::EventDeactivated, eventId);
+        Q_FOREACH (auto adapter, m_adapters)
+            adapter->eventDeactivated(eventId);
     }
 
     Q_ASSERT(eventId != 0);
-    Event &event = findEvent(eventId);
-    Event old = event;
+    const Event old = findEvent(eventId);
+    Event event = old;
+    unindexEvent(old);
     event.setEndDateTime(QDateTime::currentDateTime());
+    // stored through the store, which keeps the interned comments counted:
+    m_events.insert(event);
+    indexEvent(event);
+    markEventsChanged(Change::EventModified, eventId);
 
     emit requestEventModification(event, old);
 
@@ -458,17 +1002,24 @@ void CharmDataModel::endEventRequested(const Task &task)
 
 void CharmDataModel::endAllEventsRequested()
 {
+    const Batch batch(this);
     QDateTime currentDateTime = QDateTime::currentDateTime();
     while (!m_activeEventIds.isEmpty()) {
         EventId eventId = m_activeEventIds.first();
         m_activeEventIds.pop_front();
+        removeActiveEvent(eventId);
+        recordChange(Change::EventDeactivated, eventId);
         Q_FOREACH (auto adapter, m_adapters)
             adapter->eventDeactivated(eventId);
 
         Q_ASSERT(eventId != 0);
-        Event &event = findEvent(eventId);
-        Event old = event;
+        const Event old = findEvent(eventId);
+        Event event = old;
+        unindexEvent(old);
         event.setEndDateTime(currentDateTime);
+        m_events.insert(event);
+        indexEvent(event);
+        markEventsChanged(Change::EventModified, eventId);
 
         emit requestEventModification(event, old);
     }
@@ -479,6 +1030,7 @@ void CharmDataModel::endAllEventsRequested()
 
 void CharmDataModel::eventUpdateTimerEvent()
 {
+    const Batch batch(this);
     Q_FOREACH (EventId id, m_activeEventIds) {
         // Not a ref (Event &), since we want to diff "old event"
         // and "new event" in *Adapter::eventModified
@@ -494,12 +1046,17 @@ void CharmDataModel::eventUpdateTimerEvent()
 QString CharmDataModel::fullTaskName(const Task &task) const
 {
     if (task.isValid()) {
+        // use the cache if the task is the one stored in the model:
+        const Task &stored = getTask(task.id());
+        if (stored.isValid() && stored.parent() == task.parent() && stored.name() == task.name())
+            return cachedFullTaskName(task.id());
+
         QString name = task.name().simplified();
 
         if (task.parent() != 0) {
             const Task &parent = getTask(task.parent());
             if (parent.isValid())
-                name = fullTaskName(parent) + QLatin1Char('/') + name;
+                name = cachedFullTaskName(parent.id()) + QLatin1Char('/') + name;
         }
         return name;
     } else {
@@ -509,6 +1066,39 @@ QString CharmDataModel::fullTaskName(const Task &task) const
     }
 }
 
+const QString &CharmDataModel::cachedFullTaskName(TaskId id) const
+{
+    const auto it = m_fullTaskNames.find(id);
+    if (it != m_fullTaskNames.end())
+        return it->second.name;
+
+    const Task &task = getTask(id);
+    QString name = task.name().simplified();
+    if (task.parent() != 0) {
+        const Task &parent = getTask(task.parent());
+        if (parent.isValid())
+            name = cachedFullTaskName(parent.id()) + QLatin1Char('/') + name;
+    }
+    FullTaskName &entry = m_fullTaskNames[id];
+    entry.name = name;
+    return entry.name;
+}
+
+void CharmDataModel::invalidateFullTaskNames(TaskId id)
+{
+    // the full names of all tasks in the subtree contain the name of this task:
+    if (m_fullTaskNames.empty())
+        return;
+    std::vector<const TaskTreeItem *> items { &taskTreeItem(id) };
+    while (!items.empty()) {
+        const TaskTreeItem *item = items.back();
+        items.pop_back();
+        m_fullTaskNames.erase(item->task().id());
+        for (int row = 0; row < item->childCount(); ++row)
+            items.push_back(&item->child(row));
+    }
+}
+
 QString CharmDataModel::smartTaskName(const Task &task) const
 {
     return m_nameCache.smartName(task.id());
@@ -534,9 +1124,18 @@ QString CharmDataModel::eventsString() const
 
 QString CharmDataModel::taskIdAndFullNameString(TaskId id) const
 {
-    return QStringLiteral("%1 %2")
-           .arg(id, CONFIGURATION.taskPaddingLength, 10, QLatin1Char('0'))
-           .arg(fullTaskName(getTask(id)));
+    if (!getTask(id).isValid())
+        return QStringLiteral("%1 ").arg(id, CONFIGURATION.taskPaddingLength, 10, QLatin1Char('0'));
+
+    cachedFullTaskName(id);
+    FullTaskName &entry = m_fullTaskNames[id];
+    if (entry.idPadding != CONFIGURATION.taskPaddingLength) {
+        entry.idPadding = CONFIGURATION.taskPaddingLength;
+        entry.idAndName = QStringLiteral("%1 %2")
+                          .arg(id, entry.idPadding, 10, QLatin1Char('0'))
+                          .arg(entry.name);
+    }
+    return entry.idAndName;
 }
 
 QString CharmDataModel::taskIdAndSmartNameString(TaskId id) const
@@ -589,14 +1188,14 @@ void CharmDataModel::updateToolTip()
     emit sysTrayUpdate(toolTip, numEvents != 0);
 }
 
-const EventMap &CharmDataModel::eventMap() const
+const EventStore &CharmDataModel::eventStore() const
 {
     return m_events;
 }
 
 bool CharmDataModel::isEventActive(EventId id) const
 {
-    return m_activeEventIds.contains(id);
+    return m_activeEventTasks.count(id) > 0;
 }
 
 int CharmDataModel::activeEventCount() const
@@ -606,18 +1205,18 @@ int CharmDataModel::activeEventCount() const
 
 EventIdList CharmDataModel::eventsThatStartInTimeFrame(const QDate &start, const QDate &end) const
 {
-    // do the comparisons in UTC, which is much faster as we only need to convert
-    // start and end date then
-    const QDateTime startUTC = QDateTime(start, QTime(0, 0, 0)).toUTC();
-    const QDateTime endUTC = QDateTime(end, QTime(0, 0, 0)).toUTC();
+    // do the comparisons in UTC seconds, which only requires converting
+    // start and end date, and look up the range in the start time index:
+    const qint64 startSecs = QDateTime(start, QTime(0, 0, 0)).toSecsSinceEpoch();
+    const qint64 endSecs = QDateTime(end, QTime(0, 0, 0)).toSecsSinceEpoch();
     EventIdList events;
-    EventMap::const_iterator it;
-    for (it = m_events.begin();
-         it != m_events.end(); ++it) {
-        const Event &event(it->second);
-        if (event.startDateTime(Qt::UTC) >= startUTC && event.startDateTime(Qt::UTC) < endUTC)
-            events << event.id();
-    }
+    if (startSecs >= endSecs)
+        return events;
+
+    const auto first = m_eventsByStart.lower_bound(EventStartKey(startSecs, std::numeric_limits<EventId>::min()));
+    const auto last = m_eventsByStart.lower_bound(EventStartKey(endSecs, std::numeric_limits<EventId>::min()));
+    for (auto it = first; it != last; ++it)
+        events << it->second;
 
     return events;
 }
@@ -632,80 +1231,103 @@ bool CharmDataModel::isParentOf(TaskId parent, TaskId id) const
     Q_ASSERT_X(parent != 0, Q_FUNC_INFO, "parent is invalid (0)");
 
     if (id == parent) return false;   // a task is not it's own child
+    updateSubtreeNumbering();
     // get the item, make sure it is valid
-    const TaskTreeItem &item(taskTreeItem(id));
-    Q_ASSERT_X(item.isValid(), Q_FUNC_INFO, "No such task");
-    if (!item.isValid()) return false;
+    const auto item = m_subtreeNumbering.find(id);
+    Q_ASSERT_X(item != m_subtreeNumbering.end(), Q_FUNC_INFO, "No such task");
+    if (item == m_subtreeNumbering.end()) return false;
+    const auto ancestor = m_subtreeNumbering.find(parent);
+    if (ancestor == m_subtreeNumbering.end()) return false;
+
+    // the subtree of parent is visited between entering and leaving it:
+    return ancestor->second.enter < item->second.enter
+           && item->second.leave < ancestor->second.leave;
+}
 
-    TaskId parentId = item.task().parent();
+EventIdList CharmDataModel::eventsForTask(TaskId id) const
+{
+    EventIdList events;
+    const auto it = m_eventsByTask.find(id);
+    if (it != m_eventsByTask.end()) {
+        events.reserve(static_cast<int>(it->second.size()));
+        for (const EventStartKey &key : it->second)
+            events << key.second;
+    }
+    return events;
+}
 
-    if (parentId == parent) return true;   // found it on the path
-    if (parentId == 0) return false;   // the task has no parent
-    return isParentOf(parent, parentId);
+EventIdList CharmDataModel::eventsInSubtree(TaskId parent) const
+{
+    return eventsInSubtree(parent, std::numeric_limits<qint64>::min(),
+                           std::numeric_limits<qint64>::max());
 }
 
-EventIdList CharmDataModel::activeEvents() const
+EventIdList CharmDataModel::eventsInSubtree(TaskId parent, const QDate &start,
+                                            const QDate &end) const
 {
-    return m_activeEventIds;
+    const qint64 startSecs = QDateTime(start, QTime(0, 0, 0)).toSecsSinceEpoch();
+    const qint64 endSecs = QDateTime(end, QTime(0, 0, 0)).toSecsSinceEpoch();
+    if (startSecs >= endSecs)
+        return EventIdList();
+    return eventsInSubtree(parent, startSecs, endSecs);
 }
 
-TaskIdList CharmDataModel::mostFrequentlyUsedTasks() const
+EventIdList CharmDataModel::eventsInSubtree(TaskId parent, qint64 startSecs,
+                                            qint64 endSecs) const
 {
-    std::unordered_map<TaskId, quint32 > mfuMap;
-    const EventMap& events = eventMap();
-    for( auto it : events) {
-        mfuMap[it.second.taskId()]++;
+    EventIdList events;
+    const TaskTreeItem &root = taskTreeItem(parent);
+    if (!root.isValid())
+        return events;
+
+    // the events of every task are ordered by start time, only the range is visited:
+    const EventStartKey first(startSecs, std::numeric_limits<EventId>::min());
+    const EventStartKey last(endSecs, std::numeric_limits<EventId>::min());
+    std::vector<const TaskTreeItem *> stack(1, &root);
+    while (!stack.empty()) {
+        const TaskTreeItem *item = stack.back();
+        stack.pop_back();
+        const auto it = m_eventsByTask.find(item->task().id());
+        if (it != m_eventsByTask.end()) {
+            const auto end = it->second.lower_bound(last);
+            for (auto key = it->second.lower_bound(first); key != end; ++key)
+                events << key->second;
+        }
+        for (int i = 0; i < item->childCount(); ++i)
+            stack.push_back(&item->child(i));
     }
+    return events;
+}
 
-    const auto comp = []( quint32 a, quint32 b ){
-        return a > b;
-    };
+int CharmDataModel::longestEventDuration() const
+{
+    return m_eventDurations.empty() ? 0 : *m_eventDurations.rbegin();
+}
 
-    std::map<quint32, TaskId, decltype( comp )> mfu( comp );
-    for ( const auto kv : mfuMap ) {
-        mfu[kv.second] = kv.first;
-    }
+const DurationTable &CharmDataModel::durations() const
+{
+    return m_durations;
+}
 
-    TaskIdList out;
-    out.reserve( static_cast<int>( mfu.size() ) );
-    std::transform( mfu.cbegin(), mfu.cend(), std::inserter( out, out.begin() ),  []( const std::pair<const quint32, TaskId> &in ) {
-        return in.second;
-    });
-    return out;
+const DurationTable &CharmDataModel::subtreeDurations() const
+{
+    updateSubtreeDurations();
+    return m_subtreeDurations;
 }
 
-TaskIdList CharmDataModel::mostRecentlyUsedTasks() const
-{
-    std::unordered_map<TaskId, QDateTime> mruMap;
-    const EventMap& events = eventMap();
-    for( const auto &it : events ) {
-        const TaskId id = it.second.taskId();
-        if ( id == 0 )
-            continue;
-        // process use date
-        // Note: for a relative order, the UTC time is sufficient and much faster
-        const QDateTime date = it.second.startDateTime( Qt::UTC );
-        const auto old = mruMap.find( id );
-        if ( old != mruMap.cend() ) {
-            mruMap[id]= qMax( old->second, date );
-        } else {
-            mruMap[id]= date;
-        }
-    }
-    const auto comp = [] ( const QDateTime &a, const QDateTime &b )
-    {
-        return a > b;
-    };
-    std::map<QDateTime, TaskId, decltype( comp )> mru( comp );
-    for ( const auto &kv : mruMap ) {
-        mru[kv.second] = kv.first;
-    }
-    TaskIdList out;
-    out.reserve( static_cast<int>( mru.size() ) );
-    std::transform( mru.cbegin(), mru.cend(), std::inserter( out, out.begin() ),  []( const std::pair<const QDateTime, TaskId> &in ) {
-        return in.second;
-    });
-    return out;
+EventIdList CharmDataModel::activeEvents() const
+{
+    return m_activeEventIds;
+}
+
+TaskIdList CharmDataModel::mostFrequentlyUsedTasks(int count) const
+{
+    return topOfRanking(m_mostFrequentlyUsed, count);
+}
+
+TaskIdList CharmDataModel::mostRecentlyUsedTasks(int count) const
+{
+    return topOfRanking(m_mostRecentlyUsed, count);
 }
 
 bool CharmDataModel::operator==(const CharmDataModel &other) const
@@ -723,6 +1345,9 @@ CharmDataModel *CharmDataModel::clone() const
     auto c = new CharmDataModel();
     c->setAllTasks(getAllTasks());
     c->m_events = m_events;
+    c->rebuildEventIndexes();
     c->m_activeEventIds = m_activeEventIds;
+    c->m_activeEventsByTask = m_activeEventsByTask;
+    c->m_activeEventTasks = m_activeEventTasks;
     return c;
 }
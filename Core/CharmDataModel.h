@@ -28,11 +28,23 @@
 #define CHARMDATAMODEL_H
 
 #include <QObject>
+#include <QSet>
 #include <QTimer>
+#include <QVector>
+
+#include <deque>
+#include <list>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <utility>
 
 #include "Task.h"
 #include "State.h"
 #include "Event.h"
+#include "EventStore.h"
+#include "DurationTable.h"
+#include "CharmDataModelSnapshot.h"
 #include "TimeSpans.h"
 #include "TaskTreeItem.h"
 #include "CharmDataModelAdapterInterface.h"
@@ -57,6 +69,48 @@ public:
     CharmDataModel();
     ~CharmDataModel() override;
 
+    /** Batch groups the changes made during its lifetime, see beginBatch(). */
+    class Batch
+    {
+    public:
+        explicit Batch(CharmDataModel *model)
+            : m_model(model)
+        {
+            m_model->beginBatch();
+        }
+
+        ~Batch()
+        {
+            m_model->endBatch();
+        }
+
+    private:
+        Q_DISABLE_COPY(Batch)
+        CharmDataModel *m_model;
+    };
+
+    /** Change describes one entry of the change journal, see changesSince(). */
+    struct Change {
+        enum Kind {
+            TaskAdded,
+            TaskModified,
+            TaskDeleted,
+            TasksReset,
+            EventAdded,
+            EventModified,
+            EventDeleted,
+            EventsReset,
+            EventActivated,
+            EventDeactivated,
+            // an event loaded on demand was unloaded again, it still exists in the storage:
+            EventUnloaded
+        };
+        quint64 generation;
+        Kind kind;
+        int id; // the task or event id, 0 for resets
+    };
+    typedef QVector<Change> ChangeList;
+
     void stateChanged(State previous, State next);
     /** Register a CharmDataModelAdapterInterface. */
     void registerAdapter(CharmDataModelAdapterInterface *);
@@ -75,11 +129,13 @@ public:
     TaskList getAllTasks() const;
     /** Retrieve an event for the given event id. */
     const Event &eventForId(EventId id) const;
-    /** Constant access to the map of events. */
-    const EventMap &eventMap() const;
+    /** Constant access to the stored events. Iteration is not ordered by id. */
+    const EventStore &eventStore() const;
     /**
      * Get all events that start in a given time frame (e.g. a given day, a given week etc.)
      * More precisely, all events that start at or after @p start, and start before @p end (@p end excluded!)
+     * The events are returned ordered by their start time. The lookup uses the start time
+     * index and does not scan the whole event map.
      */
     EventIdList eventsThatStartInTimeFrame(const QDate &start, const QDate &end) const;
     // convenience overload
@@ -90,11 +146,38 @@ public:
     TaskTreeItem &parentItem(const Task &task);   // FIXME const???
     bool taskExists(TaskId id);
     /** True if task is in the subtree below parent.
-     * parent is not element of the subtree, and thus not it's own child. */
+     * parent is not element of the subtree, and thus not it's own child.
+     * This is a constant time comparison of the subtree numbering of both tasks. */
     bool isParentOf(TaskId parent, TaskId task) const;
+    /** Get the ids of all events recorded for the task with this id. */
+    EventIdList eventsForTask(TaskId id) const;
+    /** The duration of the longest event in seconds, to find events that started
+     * before a time span but end within it. */
+    int longestEventDuration() const;
+    /** Get the ids of all events recorded for the task with this id, or any
+     * task in the subtree below it. Only the events of these tasks are visited. */
+    EventIdList eventsInSubtree(TaskId parent) const;
+    /** Like eventsInSubtree(), but only the events that start at or after @p start
+     * and before @p end. */
+    EventIdList eventsInSubtree(TaskId parent, const QDate &start, const QDate &end) const;
+    /** The seconds and number of events recorded for every task per local day.
+     * The table is updated whenever events are added, modified or deleted. */
+    const DurationTable &durations() const;
+    /** Like durations(), but the entries of every task include all tasks in the subtree
+     * below it. The rollups are rebuilt after the task tree changed. */
+    const DurationTable &subtreeDurations() const;
+
+    /** Make sure the events that start at or after @p start and before @p end are loaded.
+     * This only has an effect if the model has been filled with setRecentEvents(). Events
+     * older than the recent events are requested month by month with eventsRequested().
+     * The most recently used months stay loaded, the events of other months are unloaded
+     * again. An invalid @p start loads all events. */
+    void requireEvents(const QDate &start, const QDate &end);
+    /** The start of the recent events, or an invalid date if all events are loaded. */
+    QDate eventWindowStart() const;
 
     // handling of active events:
-    /** Is an event active for the task with this id? */
+    /** Is an event active for the task with this id? This is a constant time lookup. */
     bool isTaskActive(TaskId id) const;
     /** Is this event active? */
     bool isEventActive(EventId id) const;
@@ -108,19 +191,25 @@ public:
     bool activateEvent(const Event &);
 
     /** Provide a list of the most frequently used tasks.
-      * Only tasks that have been used so far will be taken into account, so the list might be empty. */
-    TaskIdList mostFrequentlyUsedTasks() const;
+      * Only tasks that have been used so far will be taken into account, so the list might be empty.
+      * Tasks with the same number of events are ordered by task id.
+      * The ranking is maintained incrementally, retrieving the first @p count entries
+      * does not depend on the number of recorded events. A negative count returns all tasks. */
+    TaskIdList mostFrequentlyUsedTasks(int count = -1) const;
     /** Provide a list of the most recently used tasks.
-      * Only tasks that have been used so far will be taken into account, so the list might be empty. */
-    TaskIdList mostRecentlyUsedTasks() const;
+      * Only tasks that have been used so far will be taken into account, so the list might be empty.
+      * The ranking is maintained incrementally, see mostFrequentlyUsedTasks(). */
+    TaskIdList mostRecentlyUsedTasks(int count = -1) const;
 
-    /** Create a full task name from the specified TaskId. */
+    /** Create a full task name from the specified TaskId.
+        The names are cached per task, and updated when a task or one of its parents
+        is renamed or moved. */
     QString fullTaskName(const Task &) const;
 
     /** Create a "smart" task name (name and shortest path that makes the name unique) from the specified TaskId. */
     QString smartTaskName(const Task &) const;
 
-    /** Get the task id and full name as a single string. */
+    /** Get the task id and full name as a single string. The string is cached as well. */
     QString taskIdAndFullNameString(TaskId id) const;
 
     /** Get the task id and name as a single string. */
@@ -129,6 +218,24 @@ public:
     /** Get the task id and smart name as a single string. */
     QString taskIdAndSmartNameString(TaskId id) const;
 
+    /** The generation increases with every change of the tasks, events or active events. */
+    quint64 generation() const;
+    /** The generation of the last change of the tasks. */
+    quint64 taskGeneration() const;
+    /** The generation of the last change of the events or active events. */
+    quint64 eventGeneration() const;
+    /** Get the changes made after @p generation, ordered by generation.
+        Only the most recent changes are kept. If changes after @p generation have
+        already been dropped from the journal, false is returned, and the caller has
+        to rescan the model. A TasksReset or EventsReset entry requires a rescan as well. */
+    bool changesSince(quint64 generation, ChangeList *changes) const;
+
+    /** Get an immutable snapshot of the current tasks, events and active events.
+        Snapshots can be passed to other threads. Taking a snapshot copies the tasks only
+        if they changed since the last snapshot. Of the events, only the blocks holding
+        events that changed since the last snapshot are copied, the rest is shared. */
+    CharmDataModelSnapshot snapshot() const;
+
     bool operator==(const CharmDataModel &other) const;
 
 Q_SIGNALS:
@@ -138,8 +245,19 @@ Q_SIGNALS:
     void requestEventModification(const Event &, const Event &);
     void sysTrayUpdate(const QString &, bool);
     void resetGUIState();
+    /** The events that start at or after @p start and before @p end need to be loaded,
+     * see requireEvents(). An invalid @p start requests all events before @p end. */
+    void eventsRequested(const QDate &start, const QDate &end);
 
 public Q_SLOTS:
+    /** Start a batch of changes. Until the matching endBatch(), the adapters are not
+        notified about added, modified or deleted tasks and events. Batches can be nested. */
+    void beginBatch();
+    /** End a batch of changes. When the outermost batch ends, every adapter receives
+        one notification: a reset if tasks or events have been added or deleted, or
+        the modified tasks and events otherwise. */
+    void endBatch();
+
     void setAllTasks(const TaskList &tasks);
     void addTask(const Task &);
     void modifyTask(const Task &);
@@ -147,8 +265,16 @@ public Q_SLOTS:
     void clearTasks();
 
     void setAllEvents(const EventList &events);
+    /** Set the events that start at or after @p windowStart, and the unfinished events.
+     * Older events are loaded on demand, see requireEvents(). */
+    void setRecentEvents(const EventList &events, const QDate &windowStart);
+    /** Add loaded events, events that are already in the model are ignored. */
+    void addLoadedEvents(const EventList &events);
     void addEvent(const Event &);
+    /** Modify an event. If older events are loaded on demand, an event that is not
+     * in the model is added if it belongs to the loaded events, and ignored otherwise. */
     void modifyEvent(const Event &);
+    /** Delete an event. Events that are not loaded are ignored. */
     void deleteEvent(const Event &);
     void clearEvents();
 
@@ -157,7 +283,46 @@ private:
     bool eventExists(EventId id);
 
     Task &findTask(TaskId id);
-    Event &findEvent(EventId id);
+    const Event &findEvent(EventId id) const;
+
+    // maintenance of the start time and task indexes:
+    void indexEvent(const Event &event);
+    void unindexEvent(const Event &event);
+    void clearEventIndexes();
+    void rebuildEventIndexes();
+    void unrankTask(TaskId id);
+    void rankTask(TaskId id);
+    static TaskIdList topOfRanking(const TaskRanking &ranking, int count);
+
+    // maintenance of the active event lookup tables:
+    void insertActiveEvent(const Event &event);
+    void removeActiveEvent(EventId id);
+    void rebuildActiveEventIndex();
+
+    // unload the events of a month that has been loaded on demand:
+    void unloadMonth(int month);
+    // true if the event starts in the recent events or in a month loaded on demand:
+    bool isEventLoaded(const Event &event) const;
+    // remove the event from the model, for deletes and unloads:
+    void removeEvent(const Event &event, Change::Kind kind);
+
+    // increase the generation, record the change in the journal, and mark the data
+    // shared with snapshots as outdated:
+    void recordChange(Change::Kind kind, int id);
+    void markTasksChanged(Change::Kind kind, TaskId id);
+    void markEventsChanged(Change::Kind kind, EventId id);
+
+    // the subtree numbering is rebuilt lazily after the task tree changed:
+    void invalidateSubtreeNumbering();
+    void updateSubtreeNumbering() const;
+    // the subtree duration rollups are rebuilt lazily as well:
+    void updateSubtreeDurations() const;
+    void addToSubtreeDurations(const Event &event, int sign);
+    EventIdList eventsInSubtree(TaskId parent, qint64 startSecs, qint64 endSecs) const;
+
+    // the cached full task names are created on demand:
+    const QString &cachedFullTaskName(TaskId id) const;
+    void invalidateFullTaskNames(TaskId id);
 
     int totalDuration() const;
     QString eventsString() const;
@@ -167,10 +332,81 @@ private:
     TaskTreeItem::Map m_tasks;
     TaskTreeItem m_rootItem;
 
-    EventMap m_events;
+    EventStore m_events;
+    // secondary index of all events with a valid start time,
+    // ordered by start time (seconds since epoch, UTC) and event id:
+    typedef std::pair<qint64, EventId> EventStartKey;
+    std::set<EventStartKey> m_eventsByStart;
+    // secondary index of the events recorded for each task, ordered by start time
+    // (events without a start time come first):
+    std::unordered_map<TaskId, std::set<EventStartKey> > m_eventsByTask;
+    // task usage rankings, ordered by descending event count or latest start time,
+    // and ascending task id:
+    typedef std::pair<qint64, TaskId> TaskRankKey;
+    struct TaskRankLess {
+        bool operator()(const TaskRankKey &left, const TaskRankKey &right) const
+        {
+            return left.first > right.first
+                   || (left.first == right.first && left.second < right.second);
+        }
+    };
+    typedef std::set<TaskRankKey, TaskRankLess> TaskRanking;
+    TaskRanking m_mostFrequentlyUsed;
+    TaskRanking m_mostRecentlyUsed;
+    // the durations of all events:
+    std::multiset<int> m_eventDurations;
+    // pre- and post-order numbers of every task in a depth first traversal of the
+    // task tree, a task is below another if its interval is nested in the other's:
+    struct SubtreeInterval {
+        int enter = 0;
+        int leave = 0;
+    };
+    mutable std::unordered_map<TaskId, SubtreeInterval> m_subtreeNumbering;
+    mutable bool m_subtreeNumberingValid = false;
+    // durations per task and day, and their rollups to the parent tasks:
+    DurationTable m_durations;
+    mutable DurationTable m_subtreeDurations;
+    mutable bool m_subtreeDurationsValid = false;
+    // full task names, and task id and full name strings formatted with the padding length:
+    struct FullTaskName {
+        QString name;
+        QString idAndName;
+        int idPadding = -1;
+    };
+    mutable std::unordered_map<TaskId, FullTaskName> m_fullTaskNames;
     EventIdList m_activeEventIds;
+    // the active event of every task with an active event, and the task of every active event:
+    std::unordered_map<TaskId, EventId> m_activeEventsByTask;
+    std::unordered_map<EventId, TaskId> m_activeEventTasks;
     // adapters are notified when the model changes
     CharmDataModelAdapterList m_adapters;
+    // the changes collected during a batch:
+    struct PendingChanges {
+        bool resetTasks = false;
+        bool resetEvents = false;
+        QList<TaskId> modifiedTasks;
+        QSet<TaskId> modifiedTaskIds;
+        EventIdList modifiedEvents;
+        QSet<EventId> modifiedEventIds;
+    };
+    int m_batchDepth = 0;
+    PendingChanges m_pendingChanges;
+    // the generation of the model, and of the tasks and events:
+    quint64 m_generation = 0;
+    quint64 m_taskGeneration = 0;
+    quint64 m_eventGeneration = 0;
+    // the most recent changes, the generations of the entries are consecutive:
+    std::deque<Change> m_changes;
+    // the data shared with snapshots, created on demand:
+    mutable std::shared_ptr<const CharmDataModelSnapshot::TaskData> m_taskSnapshot;
+    mutable std::shared_ptr<const CharmDataModelSnapshot::EventData> m_eventSnapshot;
+    // the events added, modified or deleted since m_eventSnapshot was created:
+    mutable std::set<EventId> m_eventsChangedSinceSnapshot;
+
+    // the start of the recent events if older events are loaded on demand, and the
+    // months loaded on demand, most recently used first:
+    QDate m_eventWindowStart;
+    std::list<int> m_loadedMonths;
 
     // event update timer:
     QTimer m_timer;
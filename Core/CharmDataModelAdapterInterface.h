@@ -49,6 +49,8 @@ public:
     virtual void eventAdded(EventId id) = 0;
     // we only pass an event because it is an outdated object:
     virtual void eventModified(EventId id, Event discardedEvent) = 0;
+    // sent at the end of a batch instead of eventModified for every event:
+    virtual void eventsModified(const EventIdList &ids) = 0;
     virtual void eventAboutToBeDeleted(EventId id) = 0;
     virtual void eventDeleted(EventId id) = 0;
 
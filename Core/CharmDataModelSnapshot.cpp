@@ -0,0 +1,327 @@
+/*
+  CharmDataModelSnapshot.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CharmDataModelSnapshot.h"
+
+#include <algorithm>
+#include <limits>
+#include <unordered_set>
+
+namespace {
+const Task InvalidTask;
+const Event InvalidEvent;
+const DurationTable::DayEntries NoDurations;
+// the block of events without a start time:
+const int InvalidStartMonth = std::numeric_limits<int>::min();
+
+bool startsBefore(const Event &left, const Event &right)
+{
+    if (left.startSecsSinceEpoch() != right.startSecsSinceEpoch())
+        return left.startSecsSinceEpoch() < right.startSecsSinceEpoch();
+    return left.id() < right.id();
+}
+
+bool startsBeforeKey(const Event &event, const std::pair<qint64, EventId> &key)
+{
+    return std::make_pair(event.startSecsSinceEpoch(), event.id()) < key;
+}
+}
+
+CharmDataModelSnapshot::Durations::Durations(const std::shared_ptr<const EventData> &data)
+    : m_data(data)
+{
+}
+
+DurationTable::Entry CharmDataModelSnapshot::Durations::entry(TaskId task, const QDate &day) const
+{
+    const auto block = m_data->blocks.find(monthOf(day));
+    if (block == m_data->blocks.end())
+        return DurationTable::Entry();
+    return block->second->durations.entry(task, day);
+}
+
+DurationTable::Entry CharmDataModelSnapshot::Durations::total(TaskId task, const QDate &start,
+                                                              const QDate &end) const
+{
+    // events are counted on the day they start, so every block holds the durations of its month:
+    DurationTable::Entry sum;
+    const auto last = m_data->blocks.upper_bound(monthOf(end));
+    for (auto it = m_data->blocks.lower_bound(monthOf(start)); it != last; ++it) {
+        const DurationTable::Entry entry = it->second->durations.total(task, start, end);
+        sum.duration += entry.duration;
+        sum.eventCount += entry.eventCount;
+    }
+    return sum;
+}
+
+const DurationTable::DayEntries &CharmDataModelSnapshot::Durations::entriesOn(const QDate &day) const
+{
+    const auto block = m_data->blocks.find(monthOf(day));
+    if (block == m_data->blocks.end())
+        return NoDurations;
+    return block->second->durations.entriesOn(day);
+}
+
+TaskIdList CharmDataModelSnapshot::Durations::tasksInTimeFrame(const QDate &start,
+                                                               const QDate &end) const
+{
+    TaskIdList tasks;
+    const auto last = m_data->blocks.upper_bound(monthOf(end));
+    for (auto it = m_data->blocks.lower_bound(monthOf(start)); it != last; ++it)
+        tasks << it->second->durations.tasksInTimeFrame(start, end);
+    std::sort(tasks.begin(), tasks.end());
+    tasks.erase(std::unique(tasks.begin(), tasks.end()), tasks.end());
+    return tasks;
+}
+
+CharmDataModelSnapshot::CharmDataModelSnapshot()
+    : m_taskData(std::make_shared<TaskData>())
+    , m_eventData(std::make_shared<EventData>())
+{
+}
+
+quint64 CharmDataModelSnapshot::generation() const
+{
+    return m_generation;
+}
+
+const Task &CharmDataModelSnapshot::getTask(TaskId id) const
+{
+    const auto it = m_taskData->tasks.find(id);
+    return it != m_taskData->tasks.end() ? it->second : InvalidTask;
+}
+
+TaskList CharmDataModelSnapshot::getAllTasks() const
+{
+    TaskList tasks;
+    tasks.reserve(static_cast<int>(m_taskData->tasks.size()));
+    for (const auto &entry : m_taskData->tasks)
+        tasks << entry.second;
+    return tasks;
+}
+
+QString CharmDataModelSnapshot::fullTaskName(const Task &task) const
+{
+    if (!task.isValid())
+        return QString();
+
+    QString name = task.name().simplified();
+    for (const Task *parent = &getTask(task.parent()); parent->isValid();
+         parent = &getTask(parent->parent()))
+        name = parent->name().simplified() + QLatin1Char('/') + name;
+    return name;
+}
+
+bool CharmDataModelSnapshot::isParentOf(TaskId parent, TaskId task) const
+{
+    for (const Task *current = &getTask(getTask(task).parent()); current->isValid();
+         current = &getTask(current->parent())) {
+        if (current->id() == parent)
+            return true;
+    }
+    return false;
+}
+
+const Event &CharmDataModelSnapshot::eventForId(EventId id) const
+{
+    const auto idBlock = m_eventData->idBlocks.find(id >> IdBlockShift);
+    if (idBlock == m_eventData->idBlocks.end())
+        return InvalidEvent;
+    const auto location = idBlock->second->locations.find(id);
+    if (location == idBlock->second->locations.end())
+        return InvalidEvent;
+    const auto block = m_eventData->blocks.find(location->second.month);
+    Q_ASSERT(block != m_eventData->blocks.end());
+    if (block == m_eventData->blocks.end())
+        return InvalidEvent;
+
+    const auto &events = block->second->events;
+    const auto it = std::lower_bound(events.begin(), events.end(),
+                                     EventStartKey(location->second.start, id), startsBeforeKey);
+    return it != events.end() && it->id() == id ? *it : InvalidEvent;
+}
+
+int CharmDataModelSnapshot::eventCount() const
+{
+    return m_eventData->eventCount;
+}
+
+EventIdList CharmDataModelSnapshot::eventsThatStartInTimeFrame(const QDate &start,
+                                                               const QDate &end) const
+{
+    const qint64 startSecs = QDateTime(start, QTime(0, 0, 0)).toSecsSinceEpoch();
+    const qint64 endSecs = QDateTime(end, QTime(0, 0, 0)).toSecsSinceEpoch();
+    EventIdList events;
+    if (startSecs >= endSecs)
+        return events;
+
+    const auto last = m_eventData->blocks.upper_bound(monthOf(end));
+    for (auto block = m_eventData->blocks.lower_bound(monthOf(start)); block != last; ++block) {
+        const auto &blockEvents = block->second->events;
+        auto it = std::lower_bound(blockEvents.begin(), blockEvents.end(),
+                                   EventStartKey(startSecs, std::numeric_limits<EventId>::min()),
+                                   startsBeforeKey);
+        for (; it != blockEvents.end() && it->startSecsSinceEpoch() < endSecs; ++it)
+            events << it->id();
+    }
+    return events;
+}
+
+EventIdList CharmDataModelSnapshot::eventsThatStartInTimeFrame(const TimeSpan &timeSpan) const
+{
+    return eventsThatStartInTimeFrame(timeSpan.first, timeSpan.second);
+}
+
+EventIdList CharmDataModelSnapshot::eventsForTask(TaskId id) const
+{
+    // the blocks are ordered by month, events without a start time come first:
+    EventIdList events;
+    for (const auto &block : m_eventData->blocks) {
+        const auto it = block.second->eventsByTask.find(id);
+        if (it == block.second->eventsByTask.end())
+            continue;
+        for (EventId eventId : it->second)
+            events << eventId;
+    }
+    return events;
+}
+
+CharmDataModelSnapshot::Durations CharmDataModelSnapshot::durations() const
+{
+    return Durations(m_eventData);
+}
+
+EventIdList CharmDataModelSnapshot::activeEvents() const
+{
+    return m_activeEvents;
+}
+
+int CharmDataModelSnapshot::monthOf(const QDate &date)
+{
+    return date.year() * 12 + date.month() - 1;
+}
+
+int CharmDataModelSnapshot::monthOf(const Event &event)
+{
+    if (event.startSecsSinceEpoch() == Event::InvalidTime)
+        return InvalidStartMonth;
+    return monthOf(event.startDateTime().date());
+}
+
+std::shared_ptr<const CharmDataModelSnapshot::EventBlock>
+CharmDataModelSnapshot::makeEventBlock(std::vector<Event> events)
+{
+    auto block = std::make_shared<EventBlock>();
+    std::sort(events.begin(), events.end(), startsBefore);
+    for (const Event &event : events) {
+        block->eventsByTask[event.taskId()].push_back(event.id());
+        block->durations.addEvent(event);
+    }
+    block->events = std::move(events);
+    return block;
+}
+
+std::shared_ptr<const CharmDataModelSnapshot::EventData>
+CharmDataModelSnapshot::makeEventData(const EventStore &events)
+{
+    std::map<int, std::vector<Event> > months;
+    std::map<EventId, std::shared_ptr<IdBlock> > idBlocks;
+    for (const Event &event : events) {
+        const int month = monthOf(event);
+        months[month].push_back(event);
+        std::shared_ptr<IdBlock> &idBlock = idBlocks[event.id() >> IdBlockShift];
+        if (!idBlock)
+            idBlock = std::make_shared<IdBlock>();
+        idBlock->locations[event.id()] = { month, event.startSecsSinceEpoch() };
+    }
+
+    auto data = std::make_shared<EventData>();
+    for (auto &month : months)
+        data->blocks.emplace(month.first, makeEventBlock(std::move(month.second)));
+    for (const auto &idBlock : idBlocks)
+        data->idBlocks.emplace(idBlock.first, idBlock.second);
+    data->eventCount = events.size();
+    return data;
+}
+
+std::shared_ptr<const CharmDataModelSnapshot::EventData>
+CharmDataModelSnapshot::updateEventData(const EventData &previous, const EventStore &events,
+                                        const std::set<EventId> &changed)
+{
+    // only the maps of blocks are copied, the blocks are shared:
+    auto data = std::make_shared<EventData>(previous);
+
+    // update the id blocks, and collect the changes of every month:
+    std::map<int, std::unordered_set<EventId> > removed;
+    std::map<int, std::vector<Event> > added;
+    for (auto it = changed.begin(); it != changed.end();) {
+        const EventId key = *it >> IdBlockShift;
+        const auto existing = data->idBlocks.find(key);
+        auto idBlock = existing != data->idBlocks.end()
+                       ? std::make_shared<IdBlock>(*existing->second)
+                       : std::make_shared<IdBlock>();
+        for (; it != changed.end() && (*it >> IdBlockShift) == key; ++it) {
+            const EventId id = *it;
+            const auto location = idBlock->locations.find(id);
+            if (location != idBlock->locations.end()) {
+                removed[location->second.month].insert(id);
+                idBlock->locations.erase(location);
+                --data->eventCount;
+            }
+            if (const Event *event = events.find(id)) {
+                const int month = monthOf(*event);
+                added[month].push_back(*event);
+                idBlock->locations[id] = { month, event->startSecsSinceEpoch() };
+                ++data->eventCount;
+            }
+        }
+        if (idBlock->locations.empty())
+            data->idBlocks.erase(key);
+        else
+            data->idBlocks[key] = idBlock;
+    }
+
+    // rebuild the blocks of the months that changed:
+    std::set<int> months;
+    for (const auto &month : removed)
+        months.insert(month.first);
+    for (const auto &month : added)
+        months.insert(month.first);
+    for (int month : months) {
+        std::vector<Event> blockEvents;
+        const auto block = data->blocks.find(month);
+        if (block != data->blocks.end()) {
+            const std::unordered_set<EventId> &ids = removed[month];
+            blockEvents.reserve(block->second->events.size());
+            for (const Event &event : block->second->events) {
+                if (ids.find(event.id()) == ids.end())
+                    blockEvents.push_back(event);
+            }
+        }
+        const std::vector<Event> &newEvents = added[month];
+        blockEvents.insert(blockEvents.end(), newEvents.begin(), newEvents.end());
+        if (blockEvents.empty())
+            data->blocks.erase(month);
+        else
+            data->blocks[month] = makeEventBlock(std::move(blockEvents));
+    }
+    return data;
+}
@@ -0,0 +1,155 @@
+/*
+  CharmDataModelSnapshot.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHARMDATAMODELSNAPSHOT_H
+#define CHARMDATAMODELSNAPSHOT_H
+
+#include <map>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Task.h"
+#include "Event.h"
+#include "EventStore.h"
+#include "DurationTable.h"
+#include "TimeSpans.h"
+
+/** CharmDataModelSnapshot is an immutable copy of the tasks, events and
+    active events of a CharmDataModel at one point in time.
+    Snapshots are created with CharmDataModel::snapshot(). Copying a
+    snapshot is cheap, the task and event data is shared. A snapshot
+    can be handed to other threads, it never changes, and the model
+    only ever replaces its own references to the shared data.
+    The events are stored in blocks, one per month they start in, and
+    the event ids are mapped to their blocks in blocks of ids as well.
+    A snapshot taken after some events changed shares all blocks with
+    the previous snapshot except the ones holding the changed events.
+    The tasks are copied as a whole after any of them changed.
+    The generation identifies the state of the model the snapshot was
+    taken from.
+*/
+class CharmDataModelSnapshot
+{
+    struct EventData;
+
+public:
+    /** Durations provides the recorded seconds per task and day of a snapshot,
+        with the same queries as DurationTable. */
+    class Durations
+    {
+    public:
+        DurationTable::Entry entry(TaskId task, const QDate &day) const;
+        DurationTable::Entry total(TaskId task, const QDate &start, const QDate &end) const;
+        const DurationTable::DayEntries &entriesOn(const QDate &day) const;
+        TaskIdList tasksInTimeFrame(const QDate &start, const QDate &end) const;
+
+    private:
+        friend class CharmDataModelSnapshot;
+        explicit Durations(const std::shared_ptr<const EventData> &data);
+
+        std::shared_ptr<const EventData> m_data;
+    };
+
+    /** An empty snapshot, of generation 0. */
+    CharmDataModelSnapshot();
+
+    quint64 generation() const;
+
+    /** Retrieve a task. Returns an invalid task if it does not exist. */
+    const Task &getTask(TaskId id) const;
+    /** Get all tasks, in no particular order. */
+    TaskList getAllTasks() const;
+    /** Create a full task name, like CharmDataModel::fullTaskName(). */
+    QString fullTaskName(const Task &) const;
+    /** True if task is in the subtree below parent. */
+    bool isParentOf(TaskId parent, TaskId task) const;
+
+    /** Retrieve an event. Returns an invalid event if it does not exist. */
+    const Event &eventForId(EventId id) const;
+    int eventCount() const;
+    /** Get all events that start at or after @p start, and before @p end, ordered by start time. */
+    EventIdList eventsThatStartInTimeFrame(const QDate &start, const QDate &end) const;
+    // convenience overload
+    EventIdList eventsThatStartInTimeFrame(const TimeSpan &timeSpan) const;
+    /** Get the ids of all events recorded for the task with this id, ordered by start time. */
+    EventIdList eventsForTask(TaskId id) const;
+    /** The seconds and number of events recorded for every task per local day. */
+    Durations durations() const;
+    EventIdList activeEvents() const;
+
+private:
+    friend class CharmDataModel;
+
+    typedef std::pair<qint64, EventId> EventStartKey;
+
+    struct TaskData {
+        std::unordered_map<TaskId, Task> tasks;
+    };
+
+    // the events that start in one month:
+    struct EventBlock {
+        // ordered by start time and id:
+        std::vector<Event> events;
+        std::unordered_map<TaskId, std::vector<EventId> > eventsByTask;
+        DurationTable durations;
+    };
+
+    struct EventLocation {
+        int month;
+        qint64 start;
+    };
+
+    // the locations of the events with ids in one block of ids:
+    struct IdBlock {
+        std::unordered_map<EventId, EventLocation> locations;
+    };
+
+    struct EventData {
+        // by month, see monthOf():
+        std::map<int, std::shared_ptr<const EventBlock> > blocks;
+        // by event id, shifted by IdBlockShift:
+        std::map<EventId, std::shared_ptr<const IdBlock> > idBlocks;
+        int eventCount = 0;
+    };
+
+    static const int IdBlockShift = 10;
+
+    static int monthOf(const QDate &date);
+    static int monthOf(const Event &event);
+    static std::shared_ptr<const EventBlock> makeEventBlock(std::vector<Event> events);
+    // create the event data of all events:
+    static std::shared_ptr<const EventData> makeEventData(const EventStore &events);
+    // create the event data for the events with the @p changed ids, sharing the
+    // unchanged blocks with @p previous:
+    static std::shared_ptr<const EventData> updateEventData(const EventData &previous,
+                                                            const EventStore &events,
+                                                            const std::set<EventId> &changed);
+
+    std::shared_ptr<const TaskData> m_taskData;
+    std::shared_ptr<const EventData> m_eventData;
+    EventIdList m_activeEvents;
+    quint64 m_generation = 0;
+};
+
+#endif
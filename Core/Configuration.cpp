@@ -82,7 +82,8 @@ bool Configuration::operator==(const Configuration &other) const
            && installationId == other.installationId
            && localStorageType == other.localStorageType
            && localStorageDatabase == other.localStorageDatabase
-           && numberOfTaskSelectorEntries == other.numberOfTaskSelectorEntries;
+           && numberOfTaskSelectorEntries == other.numberOfTaskSelectorEntries
+           && eventLoadingWindow == other.eventLoadingWindow;
 }
 
 void Configuration::writeTo(QSettings &settings)
@@ -152,7 +153,8 @@ void Configuration::dump(const QString &why)
              << "--> warnUnuploadedTimesheets: " << warnUnuploadedTimesheets << Qt::endl
              << "--> requestEventComment:      " << requestEventComment << Qt::endl
              << "--> enableCommandInterface:   " << enableCommandInterface
-             << "--> numberOfTaskSelectorEntries: " << numberOfTaskSelectorEntries;
+             << "--> numberOfTaskSelectorEntries: " << numberOfTaskSelectorEntries << Qt::endl
+             << "--> eventLoadingWindow:       " << eventLoadingWindow;
 }
 
 quint32 Configuration::createInstallationId() const
@@ -81,6 +81,7 @@ public:
     bool requestEventComment = false;
     bool enableCommandInterface = false;
     int numberOfTaskSelectorEntries = 5;
+    int eventLoadingWindow = 0; // days of events loaded at startup, 0 loads all events
 
     // these are stored in QSettings, since we need this information to locate and open the database:
     QString configurationName;
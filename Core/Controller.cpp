@@ -48,31 +48,16 @@ Controller::~Controller()
 
 Event Controller::makeEvent(const Task &task)
 {
-    Event event = m_storage->makeEvent();
-    Q_ASSERT(event.isValid());
-
+    Event event;
     event.setTaskId(task.id());
-    if (m_storage->modifyEvent(event)) {
-        emit eventAdded(event);
-    } else {
-        event = Event();
-    }
-    return event;
+    return cloneEvent(event);
 }
 
 Event Controller::cloneEvent(const Event &e)
 {
-    Event event = m_storage->makeEvent();
-    Q_ASSERT(event.isValid());
-
-    int id = event.id();
-    event = e;
-    event.setId(id);
-    if (m_storage->modifyEvent(event)) {
+    const Event event = m_storage->addEvent(e);
+    if (event.isValid())
         emit eventAdded(event);
-    } else {
-        event = Event();
-    }
     return event;
 }
 
@@ -139,14 +124,30 @@ bool Controller::deleteTask(const Task &task)
 
 bool Controller::setAllTasks(const TaskList &tasks)
 {
-    if (m_storage->setAllTasks(CONFIGURATION.user, tasks)) {
-        const TaskList newTasks = m_storage->getAllTasks();
-        // tell the view about the existing tasks;
-        emit definedTasks(newTasks);
-        return true;
-    } else {
+    // beyond this, a reset of the view is cheaper than updating it task by task:
+    const int MaximumIncrementalChanges = 100;
+
+    SqlStorage::TaskListChanges changes;
+    if (!m_storage->setAllTasks(CONFIGURATION.user, tasks, &changes))
         return false;
+
+    // moving tasks resets the view anyway, and the intermediate states of the
+    // tree may not be valid while the tasks are moved one by one:
+    if (changes.parentsChanged || changes.count() > MaximumIncrementalChanges) {
+        // tell the view about the existing tasks;
+        emit definedTasks(m_storage->getAllTasks());
+    } else if (changes.count() > 0) {
+        // parents are added before their children, and deleted after them:
+        emit batchStarted();
+        Q_FOREACH (const Task &task, changes.added)
+            emit taskAdded(task);
+        Q_FOREACH (const Task &task, changes.modified)
+            emit taskUpdated(task);
+        Q_FOREACH (const Task &task, changes.deleted)
+            emit taskDeleted(task);
+        emit batchFinished();
     }
+    return true;
 }
 
 void Controller::updateSubscriptionForTask(const Task &task)
@@ -171,19 +172,20 @@ void Controller::stateChanged(State previous, State next)
     {   // yes, it is that simple:
         TaskList tasks = m_storage->getAllTasks();
         // tell the view about the existing tasks;
-        if (!Task::checkForUniqueTaskIds(tasks)) {
+        switch (Task::validateTaskList(tasks)) {
+        case Task::DuplicateTaskIds:
             throw CharmException(tr(
                                      "The Charm database is corrupted, it contains duplicate task ids. "
                                      "Please have it looked after by a professional."));
-        }
-        if (!Task::checkForTreeness(tasks)) {
+        case Task::NotATree:
             throw CharmException(tr(
                                      "The Charm database is corrupted, the tasks do not form a tree. "
                                      "Please have it looked after by a professional."));
+        case Task::ValidTaskList:
+            break;
         }
         emit definedTasks(tasks);
-        EventList events = m_storage->getAllEvents();
-        emit allEvents(events);
+        loadEvents();
         break;
     }
     case Disconnecting:
@@ -237,7 +239,9 @@ void Controller::persistMetaData(Configuration &configuration)
         { MetaKey_Key_EnableCommandInterface,
           stringForBool(configuration.enableCommandInterface) },
         { MetaKey_Key_NumberOfTaskSelectorEntries,
-          QString::number(configuration.numberOfTaskSelectorEntries) }
+          QString::number(configuration.numberOfTaskSelectorEntries) },
+        { MetaKey_Key_EventLoadingWindow,
+          QString::number(configuration.eventLoadingWindow) }
     };
     int NumberOfSettings = sizeof settings / sizeof settings[0];
 
@@ -274,6 +278,8 @@ void Controller::provideMetaData(Configuration &configuration)
     loadConfigValue(MetaKey_Key_EnableCommandInterface, configuration.enableCommandInterface);
     loadConfigValue(MetaKey_Key_NumberOfTaskSelectorEntries, configuration.numberOfTaskSelectorEntries);
     configuration.numberOfTaskSelectorEntries = qMax(0, configuration.numberOfTaskSelectorEntries);
+    loadConfigValue(MetaKey_Key_EventLoadingWindow, configuration.eventLoadingWindow);
+    configuration.eventLoadingWindow = qMax(0, configuration.eventLoadingWindow);
 
     CONFIGURATION.dump();
 }
@@ -453,6 +459,28 @@ void Controller::updateModelEventsAndTasks()
     TaskList tasks = m_storage->getAllTasks();
     // tell the view about the existing tasks;
     emit definedTasks(tasks);
-    EventList events = m_storage->getAllEvents();
-    emit allEvents(events);
+    loadEvents();
+}
+
+void Controller::loadEvents()
+{
+    if (CONFIGURATION.eventLoadingWindow <= 0) {
+        emit allEvents(m_storage->getAllEvents());
+        return;
+    }
+
+    // only load the recent events, older ones are loaded when needed:
+    const QDate windowStart = QDate::currentDate().addDays(-CONFIGURATION.eventLoadingWindow);
+    const EventList events = m_storage->getRecentEvents(QDateTime(windowStart, QTime(0, 0)));
+    emit recentEvents(events, windowStart);
+}
+
+void Controller::provideEventsInRange(const QDate &start, const QDate &end)
+{
+    Q_ASSERT_X(m_storage != nullptr, Q_FUNC_INFO, "No storage interface available");
+    if (!m_storage)
+        return;
+    // an invalid start date loads all events before end:
+    const QDateTime startTime = start.isValid() ? QDateTime(start, QTime(0, 0)) : QDateTime();
+    emit eventsInRange(m_storage->getEventsInRange(startTime, QDateTime(end, QTime(0, 0))));
 }
@@ -90,7 +90,7 @@ public:
     /** Delete the task. Send a signal to the view confirming it. */
     bool deleteTask(const Task &);
 
-    /** Set all tasks. Updates the view, after. */
+    /** Set all tasks. Updates the view with the changes, after, sent as one batch. */
     bool setAllTasks(const TaskList &);
 
     /** Export the database contents into a XML document. */
@@ -108,6 +108,11 @@ public Q_SLOTS:
     /** Receive a command from the view. */
     void executeCommand(CharmCommand *);
 
+    /** Load the events that start at or after @p start and before @p end from the
+        storage, and send them out with eventsInRange(). An invalid start date loads
+        all events before @p end. */
+    void provideEventsInRange(const QDate &start, const QDate &end);
+
     /** Receive an undo command from the view. */
     void rollbackCommand(CharmCommand *);
 
@@ -123,6 +128,13 @@ Q_SIGNALS:
 
     void allEvents(const EventList &);
 
+    /** Sends out the events that start at or after @p windowStart, or are not finished,
+        if only recent events are loaded, see Configuration::eventLoadingWindow. */
+    void recentEvents(const EventList &, const QDate &windowStart);
+
+    /** Sends out the events requested with provideEventsInRange(). */
+    void eventsInRange(const EventList &);
+
     /** This sends out the current task list. */
     void definedTasks(const TaskList &);
 
@@ -135,6 +147,12 @@ Q_SIGNALS:
     /** Delete a task from the view completely. */
     void taskDeleted(const Task &);
 
+    /** The following changes belong together, the view may update once at batchFinished(). */
+    void batchStarted();
+
+    /** All changes that belong together have been sent. */
+    void batchFinished();
+
     /** This tells the application that the controller is ready to quit.
         When the user quits the application, the application will tell
         the controller to end and commit all active events.
@@ -151,6 +169,7 @@ Q_SIGNALS:
 
 private:
     void updateSubscriptionForTask(const Task &);
+    void loadEvents();
 
     template<class T> void loadConfigValue(const QString &key, T &configValue) const;
     SqlStorage *m_storage = nullptr;
@@ -0,0 +1,129 @@
+/*
+  DurationTable.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "DurationTable.h"
+
+#include <algorithm>
+
+void DurationTable::addEvent(const Event &event)
+{
+    add(event.taskId(), event, 1);
+}
+
+void DurationTable::addEvent(TaskId task, const Event &event)
+{
+    add(task, event, 1);
+}
+
+void DurationTable::removeEvent(const Event &event)
+{
+    add(event.taskId(), event, -1);
+}
+
+void DurationTable::removeEvent(TaskId task, const Event &event)
+{
+    add(task, event, -1);
+}
+
+void DurationTable::add(TaskId task, const Event &event, int sign)
+{
+    if (event.startSecsSinceEpoch() == Event::InvalidTime)
+        return;
+    Entry entry;
+    entry.duration = sign * event.duration();
+    entry.eventCount = sign;
+    addEntry(task, event.startDateTime().date().toJulianDay(), entry);
+}
+
+void DurationTable::addEntry(TaskId task, qint64 day, const Entry &entry)
+{
+    DayEntries &entries = m_days[day];
+    Entry &stored = entries[task];
+    stored.duration += entry.duration;
+    stored.eventCount += entry.eventCount;
+    Q_ASSERT(stored.eventCount >= 0);
+    // drop entries without events, so that empty days do not pile up:
+    if (stored.eventCount <= 0) {
+        entries.erase(task);
+        if (entries.empty())
+            m_days.erase(day);
+    }
+}
+
+void DurationTable::clear()
+{
+    m_days.clear();
+}
+
+bool DurationTable::isEmpty() const
+{
+    return m_days.empty();
+}
+
+DurationTable::Entry DurationTable::entry(TaskId task, const QDate &day) const
+{
+    const auto it = m_days.find(day.toJulianDay());
+    if (it == m_days.end())
+        return Entry();
+    const auto entry = it->second.find(task);
+    if (entry == it->second.end())
+        return Entry();
+    return entry->second;
+}
+
+DurationTable::Entry DurationTable::total(TaskId task, const QDate &start, const QDate &end) const
+{
+    Entry sum;
+    const auto last = m_days.lower_bound(end.toJulianDay());
+    for (auto it = m_days.lower_bound(start.toJulianDay()); it != last; ++it) {
+        const auto entry = it->second.find(task);
+        if (entry != it->second.end()) {
+            sum.duration += entry->second.duration;
+            sum.eventCount += entry->second.eventCount;
+        }
+    }
+    return sum;
+}
+
+const DurationTable::DayEntries &DurationTable::entriesOn(const QDate &day) const
+{
+    static const DayEntries NoEntries;
+    const auto it = m_days.find(day.toJulianDay());
+    return it != m_days.end() ? it->second : NoEntries;
+}
+
+TaskIdList DurationTable::tasksInTimeFrame(const QDate &start, const QDate &end) const
+{
+    TaskIdList tasks;
+    const auto last = m_days.lower_bound(end.toJulianDay());
+    for (auto it = m_days.lower_bound(start.toJulianDay()); it != last; ++it) {
+        for (const auto &entry : it->second)
+            tasks << entry.first;
+    }
+    std::sort(tasks.begin(), tasks.end());
+    tasks.erase(std::unique(tasks.begin(), tasks.end()), tasks.end());
+    return tasks;
+}
+
+const DurationTable::Days &DurationTable::days() const
+{
+    return m_days;
+}
@@ -0,0 +1,79 @@
+/*
+  DurationTable.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DURATIONTABLE_H
+#define DURATIONTABLE_H
+
+#include <QDate>
+
+#include <map>
+#include <unordered_map>
+
+#include "Event.h"
+#include "Task.h"
+
+/** DurationTable holds the recorded seconds and the number of events
+    per task and local day.
+    Events are counted on the local day they start on, with their full
+    duration, like in the weekly summaries and time sheets. Events
+    without a start time are not counted. The days are ordered, so
+    looking up a time frame only visits the days in it, no matter how
+    much history is stored.
+*/
+class DurationTable
+{
+public:
+    struct Entry {
+        int duration = 0;
+        int eventCount = 0;
+    };
+    typedef std::unordered_map<TaskId, Entry> DayEntries;
+    // the entries of every day, by Julian day number:
+    typedef std::map<qint64, DayEntries> Days;
+
+    /** Add the event to the entries of its task. */
+    void addEvent(const Event &event);
+    /** Add the event to the entries of the given task, e.g. one of its ancestors. */
+    void addEvent(TaskId task, const Event &event);
+    void removeEvent(const Event &event);
+    void removeEvent(TaskId task, const Event &event);
+    /** Add the entry to the entries of the task on the Julian day @p day. */
+    void addEntry(TaskId task, qint64 day, const Entry &entry);
+    void clear();
+    bool isEmpty() const;
+
+    /** The entry of the task on this day. */
+    Entry entry(TaskId task, const QDate &day) const;
+    /** The sum of the entries of the task from @p start up to @p end (@p end excluded). */
+    Entry total(TaskId task, const QDate &start, const QDate &end) const;
+    /** The entries of all tasks on this day. */
+    const DayEntries &entriesOn(const QDate &day) const;
+    /** The tasks with entries from @p start up to @p end (@p end excluded), sorted by id. */
+    TaskIdList tasksInTimeFrame(const QDate &start, const QDate &end) const;
+    const Days &days() const;
+
+private:
+    void add(TaskId task, const Event &event, int sign);
+
+    Days m_days;
+};
+
+#endif
@@ -36,8 +36,8 @@ bool Event::operator ==(const Event &other) const
     return other.id() == id()
            && other.taskId() == taskId()
            && other.comment() == comment()
-           && other.startDateTime() == startDateTime()
-           && other.endDateTime() == endDateTime()
+           && other.m_start == m_start
+           && other.m_end == m_end
            && other.userId() == userId()
            && other.reportId() == reportId();
 }
@@ -97,38 +97,55 @@ void Event::setComment(const QString &comment)
     m_comment = comment;
 }
 
+constexpr qint64 Event::InvalidTime;
+
+static QDateTime dateTimeFromSecs(qint64 secs, Qt::TimeSpec timeSpec)
+{
+    if (secs == Event::InvalidTime)
+        return QDateTime();
+    return QDateTime::fromSecsSinceEpoch(secs, Qt::UTC).toTimeSpec(timeSpec);
+}
+
+static qint64 secsFromDateTime(const QDateTime &dateTime)
+{
+    // only whole seconds are stored, this is necessary for the precision of serialization:
+    return dateTime.isValid() ? dateTime.toSecsSinceEpoch() : Event::InvalidTime;
+}
+
 QDateTime Event::startDateTime(Qt::TimeSpec timeSpec) const
 {
-    return m_start.toTimeSpec(timeSpec);
+    return dateTimeFromSecs(m_start, timeSpec);
 }
 
 void Event::setStartDateTime(const QDateTime &start)
 {
-    m_start = start.toUTC();
-    // strip milliseconds, this is necessary for the precision of serialization:
-    m_start = m_start.addMSecs(-m_start.time().msec());
-    Q_ASSERT(qAbs(m_start.secsTo(start)) <= 1);
-    Q_ASSERT(m_start.time().msec() == 0);
+    m_start = secsFromDateTime(start);
 }
 
 QDateTime Event::endDateTime(Qt::TimeSpec timeSpec) const
 {
-    return m_end.toTimeSpec(timeSpec);
+    return dateTimeFromSecs(m_end, timeSpec);
 }
 
 void Event::setEndDateTime(const QDateTime &end)
 {
-    m_end = end.toUTC();
-    // strip milliseconds, this is necessary for the precision of serialization:
-    m_end = m_end.addMSecs(-m_end.time().msec());
-    Q_ASSERT(qAbs(m_end.secsTo(end)) <= 1);
-    Q_ASSERT(m_end.time().msec() == 0);
+    m_end = secsFromDateTime(end);
+}
+
+qint64 Event::startSecsSinceEpoch() const
+{
+    return m_start;
+}
+
+qint64 Event::endSecsSinceEpoch() const
+{
+    return m_end;
 }
 
 int Event::duration() const
 {
-    if (m_start.isValid() && m_end.isValid()) {
-        return m_start.secsTo(m_end);
+    if (m_start != InvalidTime && m_end != InvalidTime) {
+        return static_cast<int>(m_end - m_start);
     } else {
         return 0;
     }
@@ -165,10 +182,10 @@ QDomElement Event::toXml(QDomDocument document) const
     element.setAttribute(EventTaskIdAttribute, QString().setNum(taskId()));
     element.setAttribute(EventUserIdAttribute, QString().setNum(userId()));
     element.setAttribute(EventReportIdAttribute, QString().setNum(reportId()));
-    if (m_start.isValid())
-        element.setAttribute(EventStartAttribute, m_start.toString(Qt::ISODate));
-    if (m_end.isValid())
-        element.setAttribute(EventEndAttribute, m_end.toString(Qt::ISODate));
+    if (m_start != InvalidTime)
+        element.setAttribute(EventStartAttribute, startDateTime(Qt::UTC).toString(Qt::ISODate));
+    if (m_end != InvalidTime)
+        element.setAttribute(EventEndAttribute, endDateTime(Qt::UTC).toString(Qt::ISODate));
     if (!comment().isEmpty()) {
         QDomText commentText = document.createTextNode(comment());
         element.appendChild(commentText);
@@ -24,7 +24,7 @@
 #ifndef CHARM_EVENT_H
 #define CHARM_EVENT_H
 
-#include <map>
+#include <limits>
 
 #include <QList>
 #include <QtDebug>
@@ -81,9 +81,20 @@ public:
 
     void setEndDateTime(const QDateTime &end = QDateTime::currentDateTime());
 
+    /** Returns the start of the event in seconds since the epoch (UTC).
+        Returns InvalidTime if no start has been set. */
+    qint64 startSecsSinceEpoch() const;
+
+    /** Returns the end of the event in seconds since the epoch (UTC).
+        Returns InvalidTime if no end has been set. */
+    qint64 endSecsSinceEpoch() const;
+
     /** Returns the duration of this event in seconds. */
     int duration() const;
 
+    /** Marks an unset start or end time. It sorts before all valid times. */
+    static constexpr qint64 InvalidTime = std::numeric_limits<qint64>::min();
+
     void dump() const;
 
     QDomElement toXml(QDomDocument) const;
@@ -104,10 +115,11 @@ private:
     /** A possible user comment.
         May be empty. */
     QString m_comment;
-    /** The start datetime of the event. */
-    QDateTime m_start;
-    /** The end datetime of the event. */
-    QDateTime m_end;
+    /** The start of the event, in seconds since the epoch (UTC).
+        Storing plain integers keeps events small and cheap to copy and compare. */
+    qint64 m_start = InvalidTime;
+    /** The end of the event, in seconds since the epoch (UTC). */
+    qint64 m_end = InvalidTime;
 };
 
 /** A list of events. */
@@ -116,9 +128,6 @@ typedef QList<Event> EventList;
 /** A list of event ids. */
 typedef QList<EventId> EventIdList;
 
-/** A map of events. */
-typedef std::map<EventId, Event> EventMap;
-
 void dumpEvents(const EventList &events);
 
 #endif
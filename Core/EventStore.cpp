@@ -0,0 +1,146 @@
+/*
+  EventStore.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "EventStore.h"
+
+int EventStore::size() const
+{
+    return static_cast<int>(m_slotForId.size());
+}
+
+bool EventStore::isEmpty() const
+{
+    return m_slotForId.empty();
+}
+
+bool EventStore::contains(EventId id) const
+{
+    return m_slotForId.find(id) != m_slotForId.end();
+}
+
+const Event *EventStore::find(EventId id) const
+{
+    const auto it = m_slotForId.find(id);
+    if (it == m_slotForId.end())
+        return nullptr;
+    return &m_slots[it->second];
+}
+
+void EventStore::insert(const Event &event)
+{
+    // free slots are marked by invalid events:
+    Q_ASSERT_X(event.isValid(), Q_FUNC_INFO, "Only valid events can be stored");
+    if (!event.isValid())
+        return;
+
+    Event *existing = nullptr;
+    const auto it = m_slotForId.find(event.id());
+    if (it != m_slotForId.end()) {
+        existing = &m_slots[it->second];
+        releaseComment(existing->comment());
+    } else {
+        int slot;
+        if (!m_freeSlots.empty()) {
+            slot = m_freeSlots.back();
+            m_freeSlots.pop_back();
+        } else {
+            slot = static_cast<int>(m_slots.size());
+            m_slots.emplace_back();
+        }
+        m_slotForId[event.id()] = slot;
+        existing = &m_slots[slot];
+    }
+    *existing = event;
+    existing->setComment(acquireComment(event.comment()));
+}
+
+bool EventStore::remove(EventId id)
+{
+    const auto it = m_slotForId.find(id);
+    if (it == m_slotForId.end())
+        return false;
+
+    const int slot = it->second;
+    releaseComment(m_slots[slot].comment());
+    m_slots[slot] = Event();
+    m_freeSlots.push_back(slot);
+    m_slotForId.erase(it);
+    return true;
+}
+
+void EventStore::clear()
+{
+    m_slots.clear();
+    m_freeSlots.clear();
+    m_slotForId.clear();
+    m_comments.clear();
+}
+
+void EventStore::reserve(int count)
+{
+    m_slotForId.reserve(count);
+}
+
+EventStore::const_iterator EventStore::begin() const
+{
+    return const_iterator(m_slots.cbegin(), m_slots.cend());
+}
+
+EventStore::const_iterator EventStore::end() const
+{
+    return const_iterator(m_slots.cend(), m_slots.cend());
+}
+
+bool EventStore::operator==(const EventStore &other) const
+{
+    if (size() != other.size())
+        return false;
+
+    for (const Event &event : *this) {
+        const Event *otherEvent = other.find(event.id());
+        if (!otherEvent || *otherEvent != event)
+            return false;
+    }
+    return true;
+}
+
+QString EventStore::acquireComment(const QString &comment)
+{
+    if (comment.isEmpty())
+        return QString();
+
+    auto it = m_comments.find(comment);
+    if (it == m_comments.end())
+        it = m_comments.insert(comment, 0);
+    ++it.value();
+    return it.key();
+}
+
+void EventStore::releaseComment(const QString &comment)
+{
+    if (comment.isEmpty())
+        return;
+
+    const auto it = m_comments.find(comment);
+    Q_ASSERT(it != m_comments.end());
+    if (it != m_comments.end() && --it.value() == 0)
+        m_comments.erase(it);
+}
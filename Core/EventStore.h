@@ -0,0 +1,140 @@
+/*
+  EventStore.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef EVENTSTORE_H
+#define EVENTSTORE_H
+
+#include <QHash>
+#include <QString>
+
+#include <deque>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+
+#include "Event.h"
+
+/** EventStore holds the events of the data model.
+    Events are kept in slots of a deque, which stores them in large
+    contiguous blocks instead of one heap node per event. A hash table
+    maps event ids to slots. Slots of removed events are reused by
+    later inserts. References to stored events stay valid until the
+    event is removed, inserting other events never moves them.
+    Comments are interned, so that events with the same comment share
+    the string data. An interned comment is dropped when the last event
+    using it is removed or changed.
+    Iteration visits all stored events in slot order, not in id order.
+*/
+class EventStore
+{
+    typedef std::deque<Event> Slots;
+
+public:
+    class const_iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef Event value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const Event *pointer;
+        typedef const Event &reference;
+
+        const_iterator(Slots::const_iterator it, Slots::const_iterator end)
+            : m_it(it)
+            , m_end(end)
+        {
+            skipFreeSlots();
+        }
+
+        const Event &operator*() const
+        {
+            return *m_it;
+        }
+
+        const Event *operator->() const
+        {
+            return &*m_it;
+        }
+
+        const_iterator &operator++()
+        {
+            ++m_it;
+            skipFreeSlots();
+            return *this;
+        }
+
+        bool operator==(const const_iterator &other) const
+        {
+            return m_it == other.m_it;
+        }
+
+        bool operator!=(const const_iterator &other) const
+        {
+            return m_it != other.m_it;
+        }
+
+    private:
+        void skipFreeSlots()
+        {
+            while (m_it != m_end && !m_it->isValid())
+                ++m_it;
+        }
+
+        Slots::const_iterator m_it;
+        Slots::const_iterator m_end;
+    };
+
+    int size() const;
+    bool isEmpty() const;
+    bool contains(EventId id) const;
+    /** Returns the stored event with this id, or nullptr.
+        Stored events are only changed through insert(), which keeps the
+        interned comments counted. */
+    const Event *find(EventId id) const;
+    /** Insert the event, or replace the stored event with the same id. */
+    void insert(const Event &event);
+    /** Remove the event with this id. Returns false if there is no such event. */
+    bool remove(EventId id);
+    void clear();
+    void reserve(int count);
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    /** Two stores are equal if they contain the same events, in any order. */
+    bool operator==(const EventStore &other) const;
+    bool operator!=(const EventStore &other) const
+    {
+        return !operator==(other);
+    }
+
+private:
+    QString acquireComment(const QString &comment);
+    void releaseComment(const QString &comment);
+
+    Slots m_slots;
+    std::vector<int> m_freeSlots;
+    std::unordered_map<EventId, int> m_slotForId;
+    // the interned comments, with the number of stored events using them:
+    QHash<QString, int> m_comments;
+};
+
+#endif
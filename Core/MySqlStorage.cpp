@@ -110,6 +110,7 @@ MySqlStorage::MySqlStorage()
 
 MySqlStorage::~MySqlStorage()
 {
+    clearPreparedQueries();
 }
 
 bool MySqlStorage::createDatabaseTables()
@@ -140,6 +141,14 @@ bool MySqlStorage::createDatabaseTables()
             query.prepare(statement);
             if (!runQuery(query))
                 error = true;
+
+            // create the indexes of the new table:
+            Q_FOREACH (const QString &indexStatement, createIndexStatements(Tables[i])) {
+                QSqlQuery indexQuery(database());
+                indexQuery.prepare(indexStatement);
+                if (!runQuery(indexQuery))
+                    error = true;
+            }
         }
     }
 
@@ -214,6 +223,7 @@ MySqlStorage::Parameters MySqlStorage::parseParameterEnvironmentVariable()
 
 void MySqlStorage::configure(const Parameters &parameters)
 {
+    clearPreparedQueries();
     database().setHostName(parameters.host);
     database().setDatabaseName(parameters.database);
     database().setUserName(parameters.name);
@@ -23,71 +23,91 @@
 
 #include "SmartNameCache.h"
 
-struct IdLessThan
-{
-    bool operator()(const Task &lhs, const Task &rhs) const
-    {
-        return lhs.id() < rhs.id();
-    }
-};
+#include <algorithm>
 
 void SmartNameCache::setAllTasks(const TaskList &taskList)
 {
-    m_tasks = taskList;
-    sortTasks();
-    regenerateSmartNames();
-}
+    clearTasks();
+    m_tasks.reserve(taskList.size());
+    Q_FOREACH (const Task &task, taskList) {
+        m_tasks.insert(task.id(), task);
+        m_childrenById[task.parent()].append(task.id());
+    }
 
-void SmartNameCache::sortTasks()
-{
-    std::sort(m_tasks.begin(), m_tasks.end(), IdLessThan());
+    QSet<QString> groups;
+    groupTasks(m_tasks.keys(), groups);
+    regenerateSmartNames(groups);
 }
 
-//single add/modify/delete rebuild the cache each time.
-//If necessary, this could be optimized by keeping the tasks in a "inverse" tree
-//with the task names below the root and their parents further down
+// single add/modify/delete only disambiguate the groups of the tasks that changed.
+// Renaming or moving a task changes the combined names of its children, and the
+// smart names of all tasks below it that had to be extended up to it, so the groups
+// of the whole subtree are regenerated.
 
 void SmartNameCache::modifyTask(const Task &task)
 {
-    const TaskList::Iterator it
-        = std::equal_range(m_tasks.begin(), m_tasks.end(), Task(task.id(), QString()), IdLessThan()).first;
-    if (it != m_tasks.end())
-        *it = task;
-    sortTasks();
-    regenerateSmartNames();
+    const auto it = m_tasks.find(task.id());
+    if (it == m_tasks.end())
+        return;
+
+    const TaskIdList ids = subtree(task.id());
+    QSet<QString> changedGroups;
+    ungroupTasks(ids, changedGroups);
+    if (it->parent() != task.parent()) {
+        m_childrenById[it->parent()].removeOne(task.id());
+        m_childrenById[task.parent()].append(task.id());
+    }
+    *it = task;
+    groupTasks(ids, changedGroups);
+    regenerateSmartNames(changedGroups);
 }
 
 void SmartNameCache::deleteTask(const Task &task)
 {
-    const auto it = std::equal_range(m_tasks.begin(), m_tasks.end(), Task(task.id(),
-                                                                     QString()), IdLessThan()).first;
-    if (it != m_tasks.end()) {
-        m_tasks.erase(it);
-        regenerateSmartNames();
-    }
+    const auto it = m_tasks.find(task.id());
+    if (it == m_tasks.end())
+        return;
+
+    const TaskIdList ids = subtree(task.id());
+    QSet<QString> changedGroups;
+    ungroupTasks(ids, changedGroups);
+    m_childrenById[it->parent()].removeOne(task.id());
+    m_tasks.erase(it);
+    m_smartTaskNamesById.remove(task.id());
+    // remaining children are orphans now, and named without their parent:
+    groupTasks(ids.mid(1), changedGroups);
+    regenerateSmartNames(changedGroups);
 }
 
 void SmartNameCache::clearTasks()
 {
     m_tasks.clear();
+    m_childrenById.clear();
+    m_tasksByCombinedName.clear();
+    m_combinedNamesById.clear();
     m_smartTaskNamesById.clear();
 }
 
 Task SmartNameCache::findTask(TaskId id) const
 {
-    const auto it = std::equal_range(m_tasks.constBegin(), m_tasks.constEnd(), Task(id, QString()), IdLessThan()).first;
-    if (it != m_tasks.end()) {
-        return *it;
-    } else {
-        return Task();
-    }
+    return m_tasks.value(id);
 }
 
 void SmartNameCache::addTask(const Task &task)
 {
-    m_tasks.append(task);
-    sortTasks();
-    regenerateSmartNames();
+    if (m_tasks.contains(task.id())) {
+        modifyTask(task);
+        return;
+    }
+
+    m_tasks.insert(task.id(), task);
+    m_childrenById[task.parent()].append(task.id());
+    // the new task may be the parent of tasks that have been added before it:
+    const TaskIdList ids = subtree(task.id());
+    QSet<QString> changedGroups;
+    ungroupTasks(ids.mid(1), changedGroups);
+    groupTasks(ids, changedGroups);
+    regenerateSmartNames(changedGroups);
 }
 
 QString SmartNameCache::smartName(const TaskId &id) const
@@ -109,15 +129,71 @@ QString SmartNameCache::makeCombined(const Task &task) const
     }
 }
 
-void SmartNameCache::regenerateSmartNames()
+TaskIdList SmartNameCache::subtree(TaskId id) const
 {
-    m_smartTaskNamesById.clear();
+    TaskIdList ids;
+    ids.append(id);
+    for (int i = 0; i < ids.size(); ++i)
+        ids.append(m_childrenById.value(ids.at(i)));
+    return ids;
+}
+
+void SmartNameCache::ungroupTasks(const TaskIdList &ids, QSet<QString> &changedGroups)
+{
+    Q_FOREACH (TaskId id, ids) {
+        const auto it = m_combinedNamesById.find(id);
+        if (it == m_combinedNamesById.end())
+            continue;
+        const auto group = m_tasksByCombinedName.find(*it);
+        Q_ASSERT(group != m_tasksByCombinedName.end());
+        group->remove(id);
+        if (group->isEmpty())
+            m_tasksByCombinedName.erase(group);
+        changedGroups.insert(*it);
+        m_combinedNamesById.erase(it);
+    }
+}
+
+void SmartNameCache::groupTasks(const TaskIdList &ids, QSet<QString> &changedGroups)
+{
+    Q_FOREACH (TaskId id, ids) {
+        const QString combined = makeCombined(findTask(id));
+        m_combinedNamesById.insert(id, combined);
+        m_tasksByCombinedName[combined].insert(id);
+        changedGroups.insert(combined);
+    }
+}
+
+void SmartNameCache::regenerateSmartNames(const QSet<QString> &combinedNames)
+{
+    Q_FOREACH (const QString &combinedName, combinedNames)
+        regenerateSmartNames(combinedName);
+}
+
+void SmartNameCache::regenerateSmartNames(const QString &combinedName)
+{
+    const auto group = m_tasksByCombinedName.constFind(combinedName);
+    if (group == m_tasksByCombinedName.constEnd())
+        return;
+
+    if (group->size() == 1) {
+        m_smartTaskNamesById.insert(*group->constBegin(), combinedName);
+        return;
+    }
+
+    // the tasks with the same combined name are extended with the names of their
+    // ancestors, until the names are unique, or no ancestors are left:
     typedef QPair<TaskId, TaskId> TaskParentPair;
 
+    QVector<TaskId> ids = group->values().toVector();
+    std::sort(ids.begin(), ids.end());
     QMap<QString, QVector<TaskParentPair> > byName;
-
-    Q_FOREACH (const Task &task, m_tasks)
-        byName[makeCombined(task)].append(qMakePair(task.id(), task.parent()));
+    QVector<TaskParentPair> &pairs = byName[combinedName];
+    // the combined name already contains the name of the parent, continue with the grandparent:
+    Q_FOREACH (TaskId id, ids) {
+        const Task parent = findTask(findTask(id).parent());
+        pairs.append(qMakePair(id, parent.isValid() ? parent.parent() : TaskId(0)));
+    }
 
     QSet<QString> cannotMakeUnique;
 
@@ -26,6 +26,15 @@
 
 #include "Task.h"
 
+#include <QHash>
+#include <QSet>
+
+/** SmartNameCache keeps the shortest unique name of every task.
+    Tasks are grouped by their name combined with the name of their
+    parent. Only the tasks in the same group can have the same smart
+    name, and only their groups are disambiguated again when tasks are
+    added, modified or deleted.
+*/
 class SmartNameCache
 {
 public:
@@ -37,14 +46,21 @@ public:
     void clearTasks();
 
 private:
-    void regenerateSmartNames();
-    void sortTasks();
+    TaskIdList subtree(TaskId id) const;
+    void ungroupTasks(const TaskIdList &ids, QSet<QString> &changedGroups);
+    void groupTasks(const TaskIdList &ids, QSet<QString> &changedGroups);
+    void regenerateSmartNames(const QSet<QString> &combinedNames);
+    void regenerateSmartNames(const QString &combinedName);
     Task findTask(TaskId id) const;
     QString makeCombined(const Task &task) const;
 
 private:
-    QMap<TaskId, QString> m_smartTaskNamesById;
-    TaskList m_tasks;
+    QHash<TaskId, QString> m_smartTaskNamesById;
+    QHash<TaskId, Task> m_tasks;
+    QHash<TaskId, TaskIdList> m_childrenById;
+    // the tasks grouped by their combined name, and the combined name of every task:
+    QHash<QString, QSet<TaskId> > m_tasksByCombinedName;
+    QHash<TaskId, QString> m_combinedNamesById;
 };
 
 #endif
@@ -121,6 +121,7 @@ SqLiteStorage::SqLiteStorage()
 
 SqLiteStorage::~SqLiteStorage()
 {
+    clearPreparedQueries();
 }
 
 QString SqLiteStorage::lastInsertRowFunction() const
@@ -160,6 +161,14 @@ bool SqLiteStorage::createDatabaseTables()
             query.prepare(statement);
             if (!runQuery(query))
                 error = true;
+
+            // create the indexes of the new table:
+            Q_FOREACH (const QString &indexStatement, createIndexStatements(Tables[i])) {
+                QSqlQuery indexQuery(database());
+                indexQuery.prepare(indexStatement);
+                if (!runQuery(indexQuery))
+                    error = true;
+            }
         }
     }
 
@@ -193,6 +202,7 @@ bool SqLiteStorage::connect(Configuration &configuration)
     if (oldDatabaseDirectory.exists())
         migrateDatabaseDirectory(oldDatabaseDirectory, fileInfo.dir());
 
+    clearPreparedQueries();
     m_database.setHostName(QStringLiteral("localhost"));
     const QString databaseName = fileInfo.absoluteFilePath();
     m_database.setDatabaseName(databaseName);
@@ -260,6 +270,7 @@ bool SqLiteStorage::migrateDatabaseDirectory(QDir oldDirectory, const QDir &newD
 
 bool SqLiteStorage::disconnect()
 {
+    clearPreparedQueries();
     m_database.removeDatabase(DatabaseName);
     m_database.close();
     return true; // neither of the two methods return a value
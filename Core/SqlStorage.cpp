@@ -33,7 +33,10 @@
 #include <QDateTime>
 #include <QFile>
 #include <QFileInfo>
+#include <QHash>
+#include <QSet>
 #include <QSqlDatabase>
+#include <QSqlDriver>
 #include <QSqlError>
 #include <QSqlField>
 #include <QSqlQuery>
@@ -42,6 +45,25 @@
 #include <QTextStream>
 #include <QtDebug>
 
+#include <algorithm>
+
+struct Index
+{
+    QString table;
+    QString name;
+    QString columns;
+};
+
+// the secondary indexes, the same for all backends:
+static const Index Indexes[] = {
+    { QStringLiteral("Events"), QStringLiteral("events_event_id"), QStringLiteral("`event_id`") },
+    { QStringLiteral("Events"), QStringLiteral("events_task"), QStringLiteral("`task`") },
+    { QStringLiteral("Events"), QStringLiteral("events_report_user"),
+      QStringLiteral("`report_id`, `user_id`") },
+    { QStringLiteral("Events"), QStringLiteral("events_start"), QStringLiteral("`start`") },
+    { QStringLiteral("Subscriptions"), QStringLiteral("subscriptions_task"), QStringLiteral("`task`") }
+};
+
 // SqlStorage class
 
 SqlStorage::SqlStorage()
@@ -52,6 +74,40 @@ SqlStorage::~SqlStorage()
 {
 }
 
+QSqlQuery &SqlStorage::preparedQuery(const QString &statement)
+{
+    auto it = m_preparedQueries.find(statement);
+    if (it == m_preparedQueries.end()) {
+        QSqlQuery query(database());
+        query.setForwardOnly(true);
+        if (!query.prepare(statement)) {
+            // do not cache statements that failed to prepare, executing it will report the error:
+            m_unpreparedQuery = query;
+            return m_unpreparedQuery;
+        }
+        it = m_preparedQueries.insert(statement, query);
+    }
+    return it.value();
+}
+
+QStringList SqlStorage::createIndexStatements(const QString &table)
+{
+    QStringList statements;
+    for (const Index &index : Indexes) {
+        if (index.table == table) {
+            statements << QStringLiteral("CREATE INDEX `%1` ON `%2` (%3);")
+                .arg(index.name, index.table, index.columns);
+        }
+    }
+    return statements;
+}
+
+void SqlStorage::clearPreparedQueries()
+{
+    m_preparedQueries.clear();
+    m_unpreparedQuery = QSqlQuery();
+}
+
 bool SqlStorage::verifyDatabase()
 {
     // if the database is empty, it is not ok :-)
@@ -82,6 +138,10 @@ bool SqlStorage::verifyDatabase()
         return migrateDB(QStringLiteral(
                              "ALTER TABLE Tasks ADD comment varchar(256)"),
                          CHARM_DATABASE_VERSION_BEFORE_COMMENT);
+    } else if (version == CHARM_DATABASE_VERSION_BEFORE_INDEXES) {
+        return migrateDB(createIndexStatements(QStringLiteral("Events"))
+                         + createIndexStatements(QStringLiteral("Subscriptions")),
+                         CHARM_DATABASE_VERSION_BEFORE_INDEXES);
     }
 
     throw UnsupportedDatabaseVersionException(QObject::tr("Database version is not supported."));
@@ -107,26 +167,108 @@ TaskList SqlStorage::getAllTasks()
     return tasks;
 }
 
-bool SqlStorage::setAllTasks(const User &user, const TaskList &tasks)
+/** Order @p tasks so that every task comes after its parent, if the parent is in @p tasks. */
+static TaskList parentsFirst(const TaskList &tasks)
+{
+    QHash<TaskId, Task> pending;
+    pending.reserve(tasks.size());
+    Q_FOREACH (const Task &task, tasks)
+        pending.insert(task.id(), task);
+
+    TaskList ordered;
+    ordered.reserve(tasks.size());
+    TaskList chain;
+    Q_FOREACH (const Task &task, tasks) {
+        // collect the pending ancestors of the task, then emit them top down:
+        auto it = pending.find(task.id());
+        while (it != pending.end()) {
+            chain.append(it.value());
+            pending.erase(it);
+            it = pending.find(chain.last().parent());
+        }
+        while (!chain.isEmpty())
+            ordered.append(chain.takeLast());
+    }
+    return ordered;
+}
+
+bool SqlStorage::setAllTasks(const User &user, const TaskList &tasks, TaskListChanges *changes)
 {
     SqlRaiiTransactor transactor(database());
     const TaskList oldTasks = getAllTasks();
-    // clear tasks
-    deleteAllTasks(transactor);
-    // add tasks
+    QHash<TaskId, Task> oldTasksById;
+    oldTasksById.reserve(oldTasks.size());
+    Q_FOREACH (const Task &task, oldTasks)
+        oldTasksById.insert(task.id(), task);
+
+    TaskList added;
+    TaskList modified;
+    bool parentsChanged = false;
     Q_FOREACH (Task task, tasks) {
-        task.setSubscribed(false);
-        addTask(task, transactor);
-    }
-    // try to restore subscriptions where possible
-    Q_FOREACH (const Task &oldTask, oldTasks) {
-        const Task task = getTask(oldTask.id());
-        if (task.isValid()) {
-            if (oldTask.subscribed())
-                addSubscription(user, task);
+        const auto old = oldTasksById.find(task.id());
+        if (old == oldTasksById.end()) {
+            task.setSubscribed(false);
+            added.append(task);
+        } else {
+            // subscriptions are kept for tasks that already exist:
+            task.setSubscribed(old.value().subscribed());
+            if (task != old.value() || task.comment() != old.value().comment()) {
+                modified.append(task);
+                parentsChanged = parentsChanged || task.parent() != old.value().parent();
+            }
+            oldTasksById.erase(old);
         }
     }
-    transactor.commit();
+    // whatever is left was removed from the task list:
+    TaskList deleted = parentsFirst(oldTasksById.values());
+    std::reverse(deleted.begin(), deleted.end());
+    added = parentsFirst(added);
+
+    const bool tasksAdded = insertRows(
+        QStringLiteral("INSERT into Tasks (task_id, name, parent, validfrom, validuntil, trackable, comment)"),
+        7, added.size(), [&added](QSqlQuery &query, int row, int position) {
+        const Task &task = added.at(row);
+        query.bindValue(position, task.id());
+        query.bindValue(position + 1, task.name());
+        query.bindValue(position + 2, task.parent());
+        query.bindValue(position + 3, task.validFrom());
+        query.bindValue(position + 4, task.validUntil());
+        query.bindValue(position + 5, task.trackable() ? 1 : 0);
+        query.bindValue(position + 6, task.comment());
+    });
+    if (!tasksAdded)
+        return false;
+
+    Q_FOREACH (const Task &task, modified) {
+        QSqlQuery &query = preparedQuery(QStringLiteral(
+                                             "UPDATE Tasks set name = ?, parent = ?, validfrom = ?, "
+                                             "validuntil = ?, trackable = ?, comment = ? where task_id = ?;"));
+        query.bindValue(0, task.name());
+        query.bindValue(1, task.parent());
+        query.bindValue(2, task.validFrom());
+        query.bindValue(3, task.validUntil());
+        query.bindValue(4, task.trackable() ? 1 : 0);
+        query.bindValue(5, task.comment());
+        query.bindValue(6, task.id());
+        if (!runQuery(query))
+            return false;
+    }
+
+    Q_FOREACH (const Task &task, deleted) {
+        QSqlQuery &query = preparedQuery(QStringLiteral("DELETE from Tasks where task_id = ?;"));
+        query.bindValue(0, task.id());
+        if (!runQuery(query) || !deleteSubscription(user, task))
+            return false;
+    }
+
+    if (!transactor.commit())
+        return false;
+    if (changes) {
+        changes->added = added;
+        changes->modified = modified;
+        changes->deleted = deleted;
+        changes->parentsChanged = parentsChanged;
+    }
     return true;
 }
 
@@ -143,60 +285,55 @@ bool SqlStorage::addTask(const Task &task)
 
 bool SqlStorage::addTask(const Task &task, const SqlRaiiTransactor &)
 {
-    QSqlQuery query(database());
-    query.prepare(QLatin1String(
-                      "INSERT into Tasks (task_id, name, parent, validfrom, validuntil, trackable, comment) "
-                      "values ( :task_id, :name, :parent, :validfrom, :validuntil, :trackable, :comment);"));
-    query.bindValue(QStringLiteral(":task_id"), task.id());
-    query.bindValue(QStringLiteral(":name"), task.name());
-    query.bindValue(QStringLiteral(":parent"), task.parent());
-    query.bindValue(QStringLiteral(":validfrom"), task.validFrom());
-    query.bindValue(QStringLiteral(":validuntil"), task.validUntil());
-    query.bindValue(QStringLiteral(":trackable"), task.trackable() ? 1 : 0);
-    query.bindValue(QStringLiteral(":comment"), task.comment());
+    QSqlQuery &query = preparedQuery(QStringLiteral(
+                                         "INSERT into Tasks (task_id, name, parent, validfrom, validuntil, trackable, comment) "
+                                         "values ( ?, ?, ?, ?, ?, ?, ? );"));
+    query.bindValue(0, task.id());
+    query.bindValue(1, task.name());
+    query.bindValue(2, task.parent());
+    query.bindValue(3, task.validFrom());
+    query.bindValue(4, task.validUntil());
+    query.bindValue(5, task.trackable() ? 1 : 0);
+    query.bindValue(6, task.comment());
     return runQuery(query);
 }
 
 Task SqlStorage::getTask(int taskid)
 {
-    QSqlQuery query(database());
-    query.prepare(QStringLiteral(
-                      "SELECT * FROM Tasks LEFT JOIN Subscriptions ON Tasks.task_id = Subscriptions.task WHERE task_id = :id;"));
-    query.bindValue(QStringLiteral(":id"), taskid);
+    QSqlQuery &query = preparedQuery(QStringLiteral(
+                                         "SELECT * FROM Tasks LEFT JOIN Subscriptions ON Tasks.task_id = Subscriptions.task WHERE task_id = ?;"));
+    query.bindValue(0, taskid);
 
-    if (runQuery(query) && query.next()) {
-        Task task = makeTaskFromRecord(query.record());
-        return task;
-    } else {
-        return Task();
-    }
+    Task task;
+    if (runQuery(query) && query.next())
+        task = makeTaskFromRecord(query.record());
+    query.finish();
+    return task;
 }
 
 bool SqlStorage::modifyTask(const Task &task)
 {
-    QSqlQuery query(database());
-    query.prepare(QLatin1String("UPDATE Tasks set name = :name, parent = :parent, "
-                                "validfrom = :validfrom, validuntil = :validuntil, trackable = :trackable "
-                                "where task_id = :task_id;"));
-    query.bindValue(QStringLiteral(":task_id"), task.id());
-    query.bindValue(QStringLiteral(":name"), task.name());
-    query.bindValue(QStringLiteral(":parent"), task.parent());
-    query.bindValue(QStringLiteral(":validfrom"), task.validFrom());
-    query.bindValue(QStringLiteral(":validuntil"), task.validUntil());
-    query.bindValue(QStringLiteral(":trackable"), task.trackable() ? 1 : 0);
+    QSqlQuery &query = preparedQuery(QStringLiteral(
+                                         "UPDATE Tasks set name = ?, parent = ?, "
+                                         "validfrom = ?, validuntil = ?, trackable = ? "
+                                         "where task_id = ?;"));
+    query.bindValue(0, task.name());
+    query.bindValue(1, task.parent());
+    query.bindValue(2, task.validFrom());
+    query.bindValue(3, task.validUntil());
+    query.bindValue(4, task.trackable() ? 1 : 0);
+    query.bindValue(5, task.id());
     return runQuery(query);
 }
 
 bool SqlStorage::deleteTask(const Task &task)
 {
     SqlRaiiTransactor transactor(database());
-    QSqlQuery query(database());
-    query.prepare(QStringLiteral("DELETE from Tasks where task_id = :task_id;"));
-    query.bindValue(QStringLiteral(":task_id"), task.id());
+    QSqlQuery &query = preparedQuery(QStringLiteral("DELETE from Tasks where task_id = ?;"));
+    query.bindValue(0, task.id());
     bool rc = runQuery(query);
-    QSqlQuery query2(database());
-    query2.prepare(QStringLiteral("DELETE from Events where task = :task_id;"));
-    query2.bindValue(QStringLiteral(":task_id"), task.id());
+    QSqlQuery &query2 = preparedQuery(QStringLiteral("DELETE from Events where task = ?;"));
+    query2.bindValue(0, task.id());
     bool rc2 = runQuery(query2);
     if (rc && rc2) {
         transactor.commit();
@@ -265,81 +402,145 @@ EventList SqlStorage::getAllEvents()
     return events;
 }
 
-Event SqlStorage::makeEvent()
+EventList SqlStorage::getEventsInRange(const QDateTime &start, const QDateTime &end)
 {
-    SqlRaiiTransactor transactor(database());
-    Event event = makeEvent(transactor);
-    if (event.isValid())
-        transactor.commit();
-    return event;
+    EventList events;
+    QSqlQuery query(database());
+    if (start.isValid()) {
+        query.prepare(QStringLiteral("SELECT * from Events WHERE start >= :start AND start < :end "
+                                     "ORDER BY start;"));
+        // start times are stored in local time, see modifyEvent():
+        query.bindValue(QStringLiteral(":start"), start.toLocalTime());
+    } else {
+        query.prepare(QStringLiteral("SELECT * from Events WHERE start < :end ORDER BY start;"));
+    }
+    query.bindValue(QStringLiteral(":end"), end.toLocalTime());
+    if (runQuery(query)) {
+        while (query.next())
+            events.append(makeEventFromRecord(query.record()));
+    }
+    return events;
 }
 
-Event SqlStorage::makeEvent(const SqlRaiiTransactor &)
+EventList SqlStorage::getRecentEvents(const QDateTime &start)
 {
-    bool result;
-    Event event;
+    EventList events;
+    QSqlQuery query(database());
+    query.prepare(QStringLiteral("SELECT * from Events WHERE start >= :start "
+                                 "OR start IS NULL OR end IS NULL;"));
+    query.bindValue(QStringLiteral(":start"), start.toLocalTime());
+    if (runQuery(query)) {
+        while (query.next())
+            events.append(makeEventFromRecord(query.record()));
+    }
+    return events;
+}
+
+EventList SqlStorage::getEventsForTasks(const TaskIdList &ids, const QDateTime &start,
+                                        const QDateTime &end)
+{
+    // SQLite limits the number of host parameters in a statement (999 by default),
+    // large task lists are queried in chunks:
+    const int MaximumTasksPerQuery = 500;
 
-    { // insert a new record in the database
+    EventList events;
+    for (int offset = 0; offset < ids.size(); offset += MaximumTasksPerQuery) {
+        const TaskIdList chunk = ids.mid(offset, MaximumTasksPerQuery);
+        QStringList placeholders;
+        placeholders.reserve(chunk.size());
+        for (int i = 0; i < chunk.size(); ++i)
+            placeholders << QStringLiteral("?");
         QSqlQuery query(database());
-        query.prepare(QLatin1String("INSERT into Events values "
-                                    "( NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL );"));
-        result = runQuery(query);
-        Q_ASSERT(result); // this has to suceed
+        query.prepare(QStringLiteral("SELECT * from Events WHERE start >= ? AND start < ? "
+                                     "AND task IN (%1) ORDER BY start;")
+                      .arg(placeholders.join(QStringLiteral(", "))));
+        query.addBindValue(start.toLocalTime());
+        query.addBindValue(end.toLocalTime());
+        Q_FOREACH (TaskId id, chunk)
+            query.addBindValue(id);
+        if (!runQuery(query))
+            return EventList();
+        while (query.next())
+            events.append(makeEventFromRecord(query.record()));
     }
-    if (result) { // retrieve the AUTOINCREMENT id value of it
-        const QString statement = QString::fromLocal8Bit(
-            "SELECT id from Events WHERE id = %1();").arg(
-            lastInsertRowFunction());
-        QSqlQuery query(database());
-        query.prepare(statement);
-        result = runQuery(query);
-        if (result && query.next()) {
-            int indexField = query.record().indexOf(QStringLiteral("id"));
-            event.setId(query.value(indexField).toInt());
-            Q_ASSERT(event.id() > 0);
-        } else {
-            Q_ASSERT_X(false, Q_FUNC_INFO,
-                       "database implementation error (SELECT)");
-        }
+    if (ids.size() > MaximumTasksPerQuery) {
+        std::stable_sort(events.begin(), events.end(), [](const Event &left, const Event &right) {
+            return left.startSecsSinceEpoch() < right.startSecsSinceEpoch();
+        });
     }
-    if (result) {
-        // modify the created record to make sure event_id is unique
-        // within the installation:
-        QSqlQuery query(database());
-        query.prepare(QLatin1String("UPDATE Events SET event_id = :event_id, "
-                                    "installation_id = :installation_id, report_id = :report_id WHERE id = :id;"));
-        query.bindValue(QStringLiteral(":event_id"), event.id());
-        query.bindValue(QStringLiteral(":installation_id"), 1);
-        query.bindValue(QStringLiteral(":report_id"), event.reportId());
-        query.bindValue(QStringLiteral(":id"), event.id());
-        result = runQuery(query);
-        Q_ASSERT_X(result, Q_FUNC_INFO,
-                   "database implementation error (UPDATE)");
+    return events;
+}
+
+Event SqlStorage::makeEvent()
+{
+    return addEvent(Event());
+}
+
+Event SqlStorage::makeEvent(const SqlRaiiTransactor &transactor)
+{
+    return addEvent(Event(), transactor);
+}
+
+Event SqlStorage::addEvent(const Event &event)
+{
+    SqlRaiiTransactor transactor(database());
+    const Event newEvent = addEvent(event, transactor);
+    if (newEvent.isValid())
+        transactor.commit();
+    return newEvent;
+}
+
+Event SqlStorage::addEvent(const Event &event, const SqlRaiiTransactor &)
+{
+    Q_ASSERT(database().driver()->hasFeature(QSqlDriver::LastInsertId));
+
+    // the database assigns the row id, event_id has to be equal to it:
+    QSqlQuery &insert = preparedQuery(QStringLiteral(
+                                          "INSERT into Events "
+                                          "( id, event_id, installation_id, user_id, report_id, task, comment, start, end ) "
+                                          "VALUES ( NULL, NULL, ?, ?, ?, ?, ?, ?, ? );"));
+    insert.bindValue(0, 1); // installation id
+    insert.bindValue(1, event.userId());
+    insert.bindValue(2, event.reportId());
+    insert.bindValue(3, event.taskId());
+    insert.bindValue(4, event.comment());
+    insert.bindValue(5, event.startDateTime());
+    insert.bindValue(6, event.endDateTime());
+    if (!runQuery(insert)) {
+        Q_ASSERT_X(false, Q_FUNC_INFO, "database implementation error (INSERT)");
+        return Event();
     }
 
-    if (result) {
-        Q_ASSERT(event.isValid());
-        return event;
-    } else {
+    Event newEvent(event);
+    newEvent.setId(insert.lastInsertId().toInt());
+    Q_ASSERT(newEvent.isValid());
+
+    // the id is only known after the insert, so event_id is set separately:
+    QSqlQuery &update = preparedQuery(QStringLiteral(
+                                          "UPDATE Events SET event_id = ? WHERE id = ?;"));
+    update.bindValue(0, newEvent.id());
+    update.bindValue(1, newEvent.id());
+    if (!runQuery(update)) {
+        Q_ASSERT_X(false, Q_FUNC_INFO, "database implementation error (UPDATE)");
         return Event();
     }
+    return newEvent;
 }
 
 Event SqlStorage::getEvent(int id)
 {
-    QSqlQuery query(database());
-    query.prepare(QStringLiteral("SELECT * FROM Events WHERE event_id = :id;"));
-    query.bindValue(QStringLiteral(":id"), id);
+    QSqlQuery &query = preparedQuery(QStringLiteral("SELECT * FROM Events WHERE event_id = ?;"));
+    query.bindValue(0, id);
 
+    Event event;
     if (runQuery(query) && query.next()) {
-        Event event = makeEventFromRecord(query.record());
+        event = makeEventFromRecord(query.record());
         // FIXME this is going to fail with multiple installations
         Q_ASSERT(!query.next()); // eventid has to be unique
         Q_ASSERT(event.isValid()); // only valid events in database
-        return event;
-    } else {
-        return Event();
     }
+    query.finish();
+    return event;
 }
 
 bool SqlStorage:: modifyEvent(const Event &event)
@@ -355,26 +556,25 @@ bool SqlStorage:: modifyEvent(const Event &event)
 
 bool SqlStorage::modifyEvent(const Event &event, const SqlRaiiTransactor &)
 {
-    QSqlQuery query(database());
-    query.prepare(QLatin1String("UPDATE Events set task = :task, comment = :comment, "
-                                "start = :start, end = :end, user_id = :user, report_id = :report "
-                                "where event_id = :id;"));
-    query.bindValue(QStringLiteral(":id"), event.id());
-    query.bindValue(QStringLiteral(":user"), event.userId());
-    query.bindValue(QStringLiteral(":task"), event.taskId());
-    query.bindValue(QStringLiteral(":report"), event.reportId());
-    query.bindValue(QStringLiteral(":comment"), event.comment());
-    query.bindValue(QStringLiteral(":start"), event.startDateTime());
-    query.bindValue(QStringLiteral(":end"), event.endDateTime());
+    QSqlQuery &query = preparedQuery(QStringLiteral(
+                                         "UPDATE Events set task = ?, comment = ?, "
+                                         "start = ?, end = ?, user_id = ?, report_id = ? "
+                                         "where event_id = ?;"));
+    query.bindValue(0, event.taskId());
+    query.bindValue(1, event.comment());
+    query.bindValue(2, event.startDateTime());
+    query.bindValue(3, event.endDateTime());
+    query.bindValue(4, event.userId());
+    query.bindValue(5, event.reportId());
+    query.bindValue(6, event.id());
 
     return runQuery(query);
 }
 
 bool SqlStorage::deleteEvent(const Event &event)
 {
-    QSqlQuery query(database());
-    query.prepare(QStringLiteral("DELETE from Events where event_id = :id;"));
-    query.bindValue(QStringLiteral(":id"), event.id());
+    QSqlQuery &query = preparedQuery(QStringLiteral("DELETE from Events where event_id = ?;"));
+    query.bindValue(0, event.id());
 
     return runQuery(query);
 }
@@ -419,6 +619,11 @@ bool SqlStorage::runQuery(QSqlQuery &query)
 }
 
 bool SqlStorage::migrateDB(const QString &queryString, int oldVersion)
+{
+    return migrateDB(QStringList() << queryString, oldVersion);
+}
+
+bool SqlStorage::migrateDB(const QStringList &queryStrings, int oldVersion)
 {
     const QFileInfo info(Configuration::instance().localStorageDatabase);
     if (info.exists()) {
@@ -426,19 +631,21 @@ bool SqlStorage::migrateDB(const QString &queryString, int oldVersion)
                                                             .arg(oldVersion)));
     }
     SqlRaiiTransactor transactor(database());
-    QSqlQuery query(database());
-    query.prepare(queryString);
-    if (!runQuery(query)) {
-        throw UnsupportedDatabaseVersionException(QObject::tr(
-                                                      "Could not upgrade database from version %1 to version %2: %3").arg(
-                                                      QString::number(
-                                                          oldVersion),
-                                                      QString
-                                                      ::
-                                                      number(oldVersion + 1),
-                                                      query
-                                                      .
-                                                      lastError().text()));
+    Q_FOREACH (const QString &queryString, queryStrings) {
+        QSqlQuery query(database());
+        query.prepare(queryString);
+        if (!runQuery(query)) {
+            throw UnsupportedDatabaseVersionException(QObject::tr(
+                                                          "Could not upgrade database from version %1 to version %2: %3").arg(
+                                                          QString::number(
+                                                              oldVersion),
+                                                          QString
+                                                          ::
+                                                          number(oldVersion + 1),
+                                                          query
+                                                          .
+                                                          lastError().text()));
+        }
     }
     setMetaData(CHARM_DATABASE_VERSION_DESCRIPTOR, QString::number(oldVersion + 1), transactor);
     transactor.commit();
@@ -553,10 +760,10 @@ bool SqlStorage::addSubscription(User user, Task task)
     Task dbTask = getTask(task.id());
 
     if (!dbTask.isValid() || (dbTask.isValid() && !dbTask.subscribed())) {
-        QSqlQuery query(database());
-        query.prepare(QStringLiteral("INSERT into Subscriptions VALUES (NULL, :user_id, :task);"));
-        query.bindValue(QStringLiteral(":user_id"), user.id());
-        query.bindValue(QStringLiteral(":task"), task.id());
+        QSqlQuery &query = preparedQuery(QStringLiteral(
+                                             "INSERT into Subscriptions VALUES (NULL, ?, ?);"));
+        query.bindValue(0, user.id());
+        query.bindValue(1, task.id());
         return runQuery(query);
     } else {
         return true;
@@ -565,11 +772,10 @@ bool SqlStorage::addSubscription(User user, Task task)
 
 bool SqlStorage::deleteSubscription(User user, Task task)
 {
-    QSqlQuery query(database());
-    query.prepare(QStringLiteral(
-                      "DELETE from Subscriptions WHERE user_id = :user_id AND task = :task;"));
-    query.bindValue(QStringLiteral(":user_id"), user.id());
-    query.bindValue(QStringLiteral(":task"), task.id());
+    QSqlQuery &query = preparedQuery(QStringLiteral(
+                                         "DELETE from Subscriptions WHERE user_id = ? AND task = ?;"));
+    query.bindValue(0, user.id());
+    query.bindValue(1, task.id());
     return runQuery(query);
 }
 
@@ -588,29 +794,30 @@ bool SqlStorage::setMetaData(const QString &key, const QString &value, const Sql
     // find out if the key is in the database:
     bool result;
     {
-        QSqlQuery query(database());
-        query.prepare(QStringLiteral("SELECT * FROM MetaData WHERE MetaData.key = :key;"));
-        query.bindValue(QStringLiteral(":key"), key);
+        QSqlQuery &query = preparedQuery(QStringLiteral(
+                                             "SELECT * FROM MetaData WHERE MetaData.key = ?;"));
+        query.bindValue(0, key);
         if (runQuery(query) && query.next()) {
             result = true;
         } else {
             result = false;
         }
+        query.finish();
     }
 
     if (result) { // key exists, let's update:
-        QSqlQuery query(database());
-        query.prepare(QStringLiteral("UPDATE MetaData SET value = :value WHERE key = :key;"));
-        query.bindValue(QStringLiteral(":value"), value);
-        query.bindValue(QStringLiteral(":key"), key);
+        QSqlQuery &query = preparedQuery(QStringLiteral(
+                                             "UPDATE MetaData SET value = ? WHERE key = ?;"));
+        query.bindValue(0, value);
+        query.bindValue(1, key);
 
         return runQuery(query);
     } else {
         // key does not exist, let's insert:
-        QSqlQuery query(database());
-        query.prepare(QStringLiteral("INSERT INTO MetaData VALUES ( NULL, :key, :value );"));
-        query.bindValue(QStringLiteral(":key"), key);
-        query.bindValue(QStringLiteral(":value"), value);
+        QSqlQuery &query = preparedQuery(QStringLiteral(
+                                             "INSERT INTO MetaData VALUES ( NULL, ?, ? );"));
+        query.bindValue(0, key);
+        query.bindValue(1, value);
 
         return runQuery(query);
     }
@@ -620,16 +827,16 @@ bool SqlStorage::setMetaData(const QString &key, const QString &value, const Sql
 
 QString SqlStorage::getMetaData(const QString &key)
 {
-    QSqlQuery query(database());
-    query.prepare(QStringLiteral("SELECT * FROM MetaData WHERE key = :key;"));
-    query.bindValue(QStringLiteral(":key"), key);
+    QSqlQuery &query = preparedQuery(QStringLiteral("SELECT * FROM MetaData WHERE key = ?;"));
+    query.bindValue(0, key);
 
+    QString value;
     if (runQuery(query) && query.next()) {
         int valueField = query.record().indexOf(QStringLiteral("value"));
-        return query.value(valueField).toString();
-    } else {
-        return QString();
+        value = query.value(valueField).toString();
     }
+    query.finish();
+    return value;
 }
 
 Task SqlStorage::makeTaskFromRecord(const QSqlRecord &record)
@@ -667,6 +874,42 @@ Task SqlStorage::makeTaskFromRecord(const QSqlRecord &record)
     return task;
 }
 
+bool SqlStorage::insertRows(const QString &statement, int columnCount, int rowCount,
+                            const std::function<void(QSqlQuery &, int, int)> &bindRow)
+{
+    // SQLite allows at most 999 host parameters per statement by default:
+    const int MaximumParameters = 999;
+    const int maximumRows = qMax(1, MaximumParameters / columnCount);
+
+    QStringList placeholders;
+    for (int column = 0; column < columnCount; ++column)
+        placeholders << QStringLiteral("?");
+    const QString rowPlaceholders = QStringLiteral("( %1 )").arg(placeholders.join(QStringLiteral(", ")));
+
+    for (int first = 0; first < rowCount; first += maximumRows) {
+        const int rows = qMin(maximumRows, rowCount - first);
+        QStringList values;
+        values.reserve(rows);
+        for (int row = 0; row < rows; ++row)
+            values << rowPlaceholders;
+        const QString batchStatement = QStringLiteral("%1 VALUES %2;")
+                                       .arg(statement, values.join(QStringLiteral(", ")));
+        // only the full batch is cached, the remainder differs from call to call:
+        QSqlQuery remainder;
+        if (rows < maximumRows) {
+            remainder = QSqlQuery(database());
+            remainder.setForwardOnly(true);
+            remainder.prepare(batchStatement);
+        }
+        QSqlQuery &query = rows < maximumRows ? remainder : preparedQuery(batchStatement);
+        for (int row = 0; row < rows; ++row)
+            bindRow(query, first + row, row * columnCount);
+        if (!runQuery(query))
+            return false;
+    }
+    return true;
+}
+
 QString SqlStorage::setAllTasksAndEvents(const User &user, const TaskList &tasks,
                                          const EventList &events)
 {
@@ -680,38 +923,73 @@ QString SqlStorage::setAllTasksAndEvents(const User &user, const TaskList &tasks
         return QObject::tr("Error deleting the existing tasks.");
     Q_ASSERT(getAllTasks().isEmpty());
 
-    // now import Events and Tasks from the XML document:
+    // now import Events and Tasks from the XML document.
+    // The tables are empty at this point, so the rows are inserted in batches
+    // and the task ids of the events are validated in memory:
+    QSet<TaskId> taskIds;
+    taskIds.reserve(tasks.size());
+    TaskList subscribedTasks;
     Q_FOREACH (const Task &task, tasks) {
-        // don't use our own addTask method, it emits signals and that
-        // confuses the model, because the task tree is not inserted depth-first:
-        if (addTask(task, transactor)) {
-            if (task.subscribed()) {
-                bool result = addSubscription(user, task);
-                Q_ASSERT(result);
-                Q_UNUSED(result);
-            } else {
-                bool result = deleteSubscription(user, task);
-                Q_ASSERT(result);
-                Q_UNUSED(result);
-            }
-        } else {
+        taskIds.insert(task.id());
+        if (task.subscribed())
+            subscribedTasks.append(task);
+    }
+    const bool tasksAdded = insertRows(
+        QStringLiteral("INSERT into Tasks (task_id, name, parent, validfrom, validuntil, trackable, comment)"),
+        7, tasks.size(), [&tasks](QSqlQuery &query, int row, int position) {
+        const Task &task = tasks.at(row);
+        query.bindValue(position, task.id());
+        query.bindValue(position + 1, task.name());
+        query.bindValue(position + 2, task.parent());
+        query.bindValue(position + 3, task.validFrom());
+        query.bindValue(position + 4, task.validUntil());
+        query.bindValue(position + 5, task.trackable() ? 1 : 0);
+        query.bindValue(position + 6, task.comment());
+    });
+    if (!tasksAdded)
+        return QObject::tr("Cannot add imported tasks.");
+
+    {
+        QSqlQuery &query = preparedQuery(QStringLiteral(
+                                             "DELETE from Subscriptions WHERE user_id = ?;"));
+        query.bindValue(0, user.id());
+        if (!runQuery(query))
             return QObject::tr("Cannot add imported tasks.");
-        }
     }
+    const bool subscriptionsAdded = insertRows(
+        QStringLiteral("INSERT into Subscriptions (user_id, task)"),
+        2, subscribedTasks.size(), [&subscribedTasks, &user](QSqlQuery &query, int row, int position) {
+        query.bindValue(position, user.id());
+        query.bindValue(position + 1, subscribedTasks.at(row).id());
+    });
+    if (!subscriptionsAdded)
+        return QObject::tr("Cannot add imported tasks.");
+
+    EventList validEvents;
+    validEvents.reserve(events.size());
     Q_FOREACH (const Event &event, events) {
-        if (!event.isValid()) continue;
-        Task task = getTask(event.taskId());
-        if (!task.isValid()) {
-            // semantical error
-            continue;
-        }
-        Event newEvent = makeEvent(transactor);
-        int id = newEvent.id();
-        newEvent = event;
-        newEvent.setId(id);
-        if (!modifyEvent(newEvent, transactor))
-            return QObject::tr("Error adding imported event.");
-    }
+        // skip semantical errors:
+        if (event.isValid() && taskIds.contains(event.taskId()))
+            validEvents.append(event);
+    }
+    // the events table is empty, so the new ids can be assigned here:
+    const bool eventsAdded = insertRows(
+        QStringLiteral("INSERT into Events "
+                       "( id, event_id, installation_id, user_id, report_id, task, comment, start, end )"),
+        9, validEvents.size(), [&validEvents](QSqlQuery &query, int row, int position) {
+        const Event &event = validEvents.at(row);
+        query.bindValue(position, row + 1);
+        query.bindValue(position + 1, row + 1);
+        query.bindValue(position + 2, 1); // installation id
+        query.bindValue(position + 3, event.userId());
+        query.bindValue(position + 4, event.reportId());
+        query.bindValue(position + 5, event.taskId());
+        query.bindValue(position + 6, event.comment());
+        query.bindValue(position + 7, event.startDateTime());
+        query.bindValue(position + 8, event.endDateTime());
+    });
+    if (!eventsAdded)
+        return QObject::tr("Error adding imported event.");
 
     transactor.commit();
     return QString();
@@ -24,6 +24,8 @@
 #ifndef SQLSTORAGE_H
 #define SQLSTORAGE_H
 
+#include <QHash>
+#include <QSqlQuery>
 #include <QString>
 
 #include "Task.h"
@@ -32,8 +34,10 @@
 #include "Event.h"
 #include "CharmExceptions.h"
 
+#include <functional>
+
 class QSqlDatabase;
-class QSqlQuery;
+class QStringList;
 class QSqlRecord;
 class Configuration;
 class SqlRaiiTransactor;
@@ -62,9 +66,28 @@ public:
     bool modifyUser(const User &user);
     bool deleteUser(const User &user);
 
+    /** The changes setAllTasks() made to the stored tasks.
+        added is ordered parents first, deleted is ordered children first. */
+    struct TaskListChanges
+    {
+        TaskList added;
+        TaskList modified;
+        TaskList deleted;
+        /** True if one of the modified tasks moved to a different parent. */
+        bool parentsChanged = false;
+
+        int count() const
+        {
+            return added.size() + modified.size() + deleted.size();
+        }
+    };
+
     // task database functions:
     TaskList getAllTasks();
-    bool setAllTasks(const User &user, const TaskList &tasks);
+    /** Replace the stored tasks with @p tasks.
+        Only the differences to the stored tasks are written. Subscriptions of tasks that
+        remain in the list are kept. If @p changes is given, it receives the applied changes. */
+    bool setAllTasks(const User &user, const TaskList &tasks, TaskListChanges *changes = nullptr);
     bool addTask(const Task &task);
     bool addTask(const Task &task, const SqlRaiiTransactor &);
     Task getTask(int taskid);
@@ -75,10 +98,27 @@ public:
 
     // event database functions:
     EventList getAllEvents();
+    /** Get the events that start at or after @p start and before @p end.
+        An invalid @p start returns all events that start before @p end.
+        The events are returned ordered by their start time. */
+    EventList getEventsInRange(const QDateTime &start, const QDateTime &end);
+    /** Get the events that start at or after @p start, and the events without
+        a start or end time, which may still be running. */
+    EventList getRecentEvents(const QDateTime &start);
+    /** Get the events of the tasks in @p ids that start at or after @p start and before @p end.
+        The events are returned ordered by their start time. */
+    EventList getEventsForTasks(const TaskIdList &ids, const QDateTime &start,
+                                const QDateTime &end);
 
     // all events are created by the storage interface
     Event makeEvent();
     Event makeEvent(const SqlRaiiTransactor &);
+    /** Store a copy of @p event with a new id assigned by the database.
+        All fields are written in the INSERT, only event_id is set afterwards.
+        The id of @p event is ignored.
+        @return the stored event with its new id, or an invalid event on error */
+    Event addEvent(const Event &event);
+    Event addEvent(const Event &event, const SqlRaiiTransactor &);
     Event getEvent(int eventid);
     bool modifyEvent(const Event &event);
     bool modifyEvent(const Event &event, const SqlRaiiTransactor &);
@@ -115,6 +155,18 @@ public:
     static bool runQuery(QSqlQuery &);
 
 protected:
+    /** Returns the prepared query for @p statement.
+     * Queries are prepared once per connection and reused. Bind values by position
+     * and call finish() after reading the results of a SELECT, so that the statement
+     * does not keep the database locked. */
+    QSqlQuery &preparedQuery(const QString &statement);
+    /** Discard all prepared queries. Backends call this before closing or reconfiguring
+     * the connection. */
+    void clearPreparedQueries();
+    /** The statements that create the secondary indexes of @p table. New databases
+     * get them when the table is created, existing ones when they are migrated. */
+    static QStringList createIndexStatements(const QString &table);
+
     // Put the basic database structure into the database.
     // This includes creating the tables et cetera.
     // Different backends will have to reimplement this function to
@@ -132,8 +184,18 @@ protected:
 
 private:
     bool migrateDB(const QString &queryString, int oldVersion);
+    bool migrateDB(const QStringList &queryStrings, int oldVersion);
     Event makeEventFromRecord(const QSqlRecord &);
     Task makeTaskFromRecord(const QSqlRecord &);
+    /** Insert @p rowCount rows using multi-row INSERT statements.
+     * @p statement is the INSERT statement up to the VALUES clause. @p bindRow binds the
+     * values of a row, starting at the given parameter position. Only the statement
+     * for a full batch is cached, the one for the remaining rows is prepared per call. */
+    bool insertRows(const QString &statement, int columnCount, int rowCount,
+                    const std::function<void(QSqlQuery &, int row, int position)> &bindRow);
+
+    QHash<QString, QSqlQuery> m_preparedQueries;
+    QSqlQuery m_unpreparedQuery;
 };
 
 #endif
@@ -31,6 +31,8 @@
 
 #include <set>
 #include <algorithm>
+#include <unordered_map>
+#include <vector>
 
 Task::Task()
 {
@@ -149,10 +151,15 @@ void Task::setValidUntil(const QDateTime &stamp)
 }
 
 bool Task::isCurrentlyValid() const
+{
+    return isCurrentlyValid(QDateTime::currentDateTime());
+}
+
+bool Task::isCurrentlyValid(const QDateTime &now) const
 {
     return isValid()
-           && (!validFrom().isValid() || validFrom() < QDateTime::currentDateTime())
-           && (!validUntil().isValid() || validUntil() > QDateTime::currentDateTime());
+           && (!validFrom().isValid() || validFrom() < now)
+           && (!validUntil().isValid() || validUntil() > now);
 }
 
 void Task::dump() const
@@ -298,82 +305,98 @@ bool Task::checkForUniqueTaskIds(const TaskList &tasks)
     return static_cast<int>(ids.size()) == tasks.size();
 }
 
-/** collectTaskIds visits the task and all subtasks recursively, and
- * adds all visited task ids to visitedIds.
- * @returns false if any visited task id is already in visitedIds
- * @param id the parent task to traverse
- * @param visitedIds reference to a TaskId set that contains already
- * visited task ids
- * @param tasks the tasklist to process
+/** validateTaskList checks a task list in one pass for duplicate
+ * task ids, invalid tasks, orphans (tasks where the parent task does
+ * not exist) and cycles in the parent-child relationship. It runs in
+ * linear time, using a hash of the task ids and an iterative depth
+ * first traversal from the toplevel tasks.
+ *
+ * @return DuplicateTaskIds if a task id occurs more than once,
+ * NotATree if the list contains invalid tasks, orphans or cycles,
+ * ValidTaskList otherwise
+ * @param tasks the tasklist to verify
  */
-bool collectTaskIds(std::set<TaskId> &visitedIds, TaskId id, const TaskList &tasks)
-{
-    bool foundSelf = false;
-    TaskIdList children;
-
-    // find children and the task itself (the parameter tasks is not sorted)
-    for (TaskList::const_iterator it = tasks.begin(); it != tasks.end(); ++it) {
-        if ((*it).parent() == id)
-            children << (*it).id();
-        if ((*it).id() == id) {
-            // just checking that it really exists...
-            if (std::find(visitedIds.begin(), visitedIds.end(), id) != visitedIds.end()) {
-                return false;
-            } else {
-                if ((*it).isValid()) {
-                    visitedIds.insert(id);
-                    foundSelf = true;
-                } else {
-                    return false;
-                }
-            }
+Task::TaskListValidity Task::validateTaskList(const TaskList &tasks)
+{
+    const int count = tasks.size();
+    std::unordered_map<TaskId, int> indexes;
+    indexes.reserve(count);
+    bool treeness = true;
+
+    for (int i = 0; i < count; ++i) {
+        if (!indexes.emplace(tasks[i].id(), i).second)
+            return DuplicateTaskIds;
+        if (!tasks[i].isValid())
+            treeness = false;
+    }
+    if (!treeness)
+        return NotATree;
+
+    // link the children of every task, toplevel tasks are children of -1:
+    std::vector<int> firstChild(count, -1);
+    std::vector<int> nextSibling(count, -1);
+    int firstToplevel = -1;
+    for (int i = count - 1; i >= 0; --i) {
+        const TaskId parent = tasks[i].parent();
+        if (parent == 0) {
+            nextSibling[i] = firstToplevel;
+            firstToplevel = i;
+            continue;
         }
+        const auto it = indexes.find(parent);
+        if (it == indexes.end()) {
+#ifndef NDEBUG
+            qDebug() << "Orphan task:";
+            tasks[i].dump();
+#endif
+            return NotATree;
+        }
+        nextSibling[i] = firstChild[it->second];
+        firstChild[it->second] = i;
     }
 
-    if (!foundSelf)
-        return false;
+    // every task has exactly one existing parent, so the traversal
+    // cannot visit a task twice. Tasks that are not reached from the
+    // toplevel tasks are part of a cycle:
+    std::vector<bool> visited(count, false);
+    std::vector<int> stack;
+    int visitedCount = 0;
+    for (int i = firstToplevel; i != -1; i = nextSibling[i])
+        stack.push_back(i);
+    while (!stack.empty()) {
+        const int current = stack.back();
+        stack.pop_back();
+        visited[current] = true;
+        ++visitedCount;
+        for (int child = firstChild[current]; child != -1; child = nextSibling[child])
+            stack.push_back(child);
+    }
 
-    Q_FOREACH (const TaskId i, children)
-        collectTaskIds(visitedIds, i, tasks);
+    if (visitedCount != count) {
+#ifndef NDEBUG
+        for (int i = 0; i < count; ++i) {
+            if (!visited[i]) {
+                qDebug() << "Task in a cycle:";
+                tasks[i].dump();
+            }
+        }
+#endif
+        return NotATree;
+    }
 
-    return true;
+    return ValidTaskList;
 }
 
 /** checkForTreeness checks a task list against cycles in the
  * parent-child relationship, and for orphans (tasks where the parent
- * task does not exist). If the task list contains invalid tasks,
- * false is returned as well.
+ * task does not exist). If the task list contains invalid tasks or
+ * duplicate task ids, false is returned as well.
  *
  * @return false, if cycles in the task tree or orphans have been found
  * @param tasks the tasklist to verify
+ * @see validateTaskList
  */
 bool Task::checkForTreeness(const TaskList &tasks)
 {
-    std::set<TaskId> ids;
-
-    for (TaskList::const_iterator it = tasks.begin(); it != tasks.end(); ++it) {
-        if (!(*it).isValid())
-            return false;
-        if ((*it).parent() == 0) {
-            if (!collectTaskIds(ids, (*it).id(), tasks))
-                return false;
-        }
-    }
-
-    // the count of ids now must be equal to the count of tasks,
-    // otherwise tasks contains elements that are not in the subtrees
-    // of toplevel elements
-    if (ids.size() != static_cast<unsigned>(tasks.size())) {
-#ifndef NDEBUG
-        Q_FOREACH (const Task &task, tasks) {
-            if (find(ids.begin(), ids.end(), task.id()) == ids.end()) {
-                qDebug() << "Orphan task:";
-                task.dump();
-            }
-        }
-#endif
-        return false;
-    }
-
-    return true;
+    return validateTaskList(tasks) == ValidTaskList;
 }
@@ -85,6 +85,7 @@ public:
     void setValidUntil(const QDateTime &);
 
     bool isCurrentlyValid() const;
+    bool isCurrentlyValid(const QDateTime &now) const;
 
     void setTrackable(bool trackable);
     bool trackable() const;
@@ -105,6 +106,14 @@ public:
 
     static QDomElement makeTasksElement(QDomDocument, const TaskList &);
 
+    enum TaskListValidity {
+        ValidTaskList,
+        DuplicateTaskIds,
+        NotATree
+    };
+
+    static TaskListValidity validateTaskList(const TaskList &tasks);
+
     static bool checkForUniqueTaskIds(const TaskList &tasks);
 
     static bool checkForTreeness(const TaskList &tasks);
@@ -94,26 +94,31 @@ void TaskListMerger::calculateResults() const
 
     // one last check: if tasks where modified through the new task
     // lists, maybe local-only tasks have become orphans?
-    if (!Task::checkForUniqueTaskIds(m_results))
+    switch (Task::validateTaskList(m_results)) {
+    case Task::DuplicateTaskIds:
         throw InvalidTaskListException(QObject::tr(
                                            "the merged task list is invalid, it contains duplicate task ids"));
-
-    if (!Task::checkForTreeness(m_results))
+    case Task::NotATree:
         throw InvalidTaskListException(QObject::tr(
                                            "the merged tasks database is not a directed graph, this is seriously bad, go fix it"));
+    case Task::ValidTaskList:
+        break;
+    }
 
     m_resultsValid = true;
 }
 
 void TaskListMerger::verifyTaskList(const TaskList &tasks)
 {
-    if (!Task::checkForUniqueTaskIds(tasks))
+    switch (Task::validateTaskList(tasks)) {
+    case Task::DuplicateTaskIds:
         throw InvalidTaskListException(QObject::tr("task list contains duplicate task ids"));
-
-    if (!Task::checkForTreeness(tasks))
+    case Task::NotATree:
         throw InvalidTaskListException(QObject::tr(
                                            "task list is not a directed graph, this is seriously bad, go fix it"));
-
+    case Task::ValidTaskList:
+        break;
+    }
 }
 
 TaskList TaskListMerger::addedTasks() const
@@ -31,11 +31,10 @@ TaskTreeItem::TaskTreeItem()
 }
 
 TaskTreeItem::TaskTreeItem(const Task &task, TaskTreeItem *parent)
-    : m_parent(parent)
-    , m_task(task)
+    : m_task(task)
 {
-    if (m_parent)
-        m_parent->m_children.append(this);
+    if (parent)
+        attachTo(*parent);
 }
 
 TaskTreeItem::TaskTreeItem(const TaskTreeItem &other)
@@ -47,11 +46,12 @@ TaskTreeItem::TaskTreeItem(const TaskTreeItem &other)
 TaskTreeItem &TaskTreeItem::operator=(const TaskTreeItem &other)
 {
     if (this != &other) {
+        if (m_parent)
+            detachFromParent();
         m_children = other.m_children;
-        m_parent = other.m_parent;
         m_task = other.m_task;
-        if (m_parent)
-            m_parent->m_children.append(this);
+        if (other.m_parent)
+            attachTo(*other.m_parent);
     }
     return *this;
 }
@@ -59,7 +59,27 @@ TaskTreeItem &TaskTreeItem::operator=(const TaskTreeItem &other)
 TaskTreeItem::~TaskTreeItem()
 {
     if (m_parent)
-        m_parent->m_children.removeAt(row());
+        detachFromParent();
+}
+
+void TaskTreeItem::attachTo(TaskTreeItem &parent)
+{
+    Q_ASSERT(m_parent == nullptr);
+    m_parent = &parent;
+    m_row = parent.m_children.size();
+    parent.m_children.append(this);
+}
+
+void TaskTreeItem::detachFromParent()
+{
+    Q_ASSERT(m_parent && m_parent->m_children.value(m_row) == this);
+    PointerList &siblings = m_parent->m_children;
+    siblings.removeAt(m_row);
+    // the following siblings move up by one:
+    for (int i = m_row; i < siblings.size(); ++i)
+        siblings[i]->m_row = i;
+    m_parent = nullptr;
+    m_row = -1;
 }
 
 void TaskTreeItem::makeChildOf(TaskTreeItem &parent)
@@ -69,14 +89,11 @@ void TaskTreeItem::makeChildOf(TaskTreeItem &parent)
 
         // if there is an existing parent, unregister with it:
         // parent can only be zero if there never was a parent so far
-        if (m_parent != 0) {
-            m_parent->m_children.removeAt(row());
-            m_parent = nullptr;
-        }
+        if (m_parent != 0)
+            detachFromParent();
 
         // register with the new parent
-        m_parent = &parent;
-        parent.m_children.append(this);
+        attachTo(parent);
     } else {
         // hm, should this be allowed?
         // done
@@ -113,10 +130,9 @@ const TaskTreeItem &TaskTreeItem::child(int row) const
 int TaskTreeItem::row() const
 {
     if (m_parent) {
-        int row = m_parent->m_children.indexOf(this);
-        Q_ASSERT_X(row != -1, Q_FUNC_INFO,
+        Q_ASSERT_X(m_parent->m_children.value(m_row) == this, Q_FUNC_INFO,
                    "Internal error - cannot find myself in my parents family");
-        return row;
+        return m_row;
     } else {
         Q_ASSERT_X(false, Q_FUNC_INFO,
                    "Calling row() on an invalid item");
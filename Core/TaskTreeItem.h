@@ -39,12 +39,13 @@
     Every TaskTreeItem keeps a list of children.
     Every TaskTreeItem also has a position in it's parents list of
     children. This integer position can be retrieved by calling row on
-    the item.
+    the item. It is stored in the item, and the items after it are
+    renumbered when a child is removed from its parent.
 */
 class TaskTreeItem
 {
 public:
-    typedef QList<const TaskTreeItem *> ConstPointerList;
+    typedef QList<TaskTreeItem *> PointerList;
     typedef std::map<TaskId, TaskTreeItem> Map;
 
     TaskTreeItem();
@@ -76,8 +77,12 @@ public:
     TaskIdList childIds() const;
 
 private:
+    void attachTo(TaskTreeItem &parent);
+    void detachFromParent();
+
     TaskTreeItem *m_parent = nullptr;
-    ConstPointerList m_children;
+    PointerList m_children;
+    int m_row = -1;
     Task m_task;
 };
 
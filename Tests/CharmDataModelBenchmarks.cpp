@@ -0,0 +1,297 @@
+/*
+  CharmDataModelBenchmarks.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CharmDataModelBenchmarks.h"
+
+#include "Charm/TaskModelAdapter.h"
+#include "Core/CharmDataModel.h"
+
+#include <QtTest/QtTest>
+
+#include <map>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace {
+// the reference date all generated events are placed before:
+const QDateTime ReferenceDateTime(QDate(2019, 1, 1), QTime(8, 0));
+
+/** Generate @p count one hour events, spread over the days before the reference date.
+ * Events are assigned round robin to @p taskCount tasks with ids starting at 1. */
+EventList generateEvents(int count, int taskCount = 100)
+{
+    EventList events;
+    events.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        Event event;
+        event.setId(i + 1);
+        event.setTaskId(i % taskCount + 1);
+        // about 15 events per day:
+        const QDateTime start = ReferenceDateTime.addSecs(-qint64(i) * 5760);
+        event.setStartDateTime(start);
+        event.setEndDateTime(start.addSecs(3600));
+        events.append(event);
+    }
+    return events;
+}
+
+/** The event layout before EventStore, kept to compare the memory footprint. */
+struct LegacyEvent
+{
+    int userId = {};
+    int reportId = {};
+    int id = {};
+    TaskId taskId = {};
+    QString comment;
+    QDateTime start;
+    QDateTime end;
+};
+
+/** Returns the number of bytes currently allocated on the heap, or -1 if unknown. */
+qint64 allocatedBytes()
+{
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+    return static_cast<qint64>(mallinfo2().uordblks);
+#elif defined(__GLIBC__)
+    return static_cast<qint64>(mallinfo().uordblks);
+#else
+    return -1;
+#endif
+}
+
+/** Generate a task tree of @p count tasks with ids starting at 1. Task 1 is the
+ * root, every task has up to 10 children. */
+TaskList generateTasks(int count)
+{
+    TaskList tasks;
+    tasks.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        Task task;
+        task.setId(i + 1);
+        task.setParent(i == 0 ? 0 : i / 10 + 1);
+        task.setName(QStringLiteral("Task %1").arg(i + 1));
+        tasks.append(task);
+    }
+    return tasks;
+}
+
+void addEventCountColumn()
+{
+    QTest::addColumn<int>("eventCount");
+    QTest::newRow("10k") << 10000;
+    QTest::newRow("100k") << 100000;
+    QTest::newRow("1M") << 1000000;
+}
+}
+
+void CharmDataModelBenchmarks::eventsThatStartInTimeFrameScan_data()
+{
+    addEventCountColumn();
+}
+
+void CharmDataModelBenchmarks::eventsThatStartInTimeFrameScan()
+{
+    // the previous implementation of eventsThatStartInTimeFrame, as a baseline:
+    QFETCH(int, eventCount);
+    CharmDataModel model;
+    model.setAllEvents(generateEvents(eventCount));
+    const QDate start = ReferenceDateTime.date().addDays(-7);
+    const QDate end = ReferenceDateTime.date();
+    EventIdList result;
+    QBENCHMARK {
+        const QDateTime startUTC = QDateTime(start, QTime(0, 0, 0)).toUTC();
+        const QDateTime endUTC = QDateTime(end, QTime(0, 0, 0)).toUTC();
+        result.clear();
+        for (const Event &event : model.eventStore()) {
+            if (event.startDateTime(Qt::UTC) >= startUTC && event.startDateTime(Qt::UTC) < endUTC)
+                result << event.id();
+        }
+    }
+    QCOMPARE(result.size(), model.eventsThatStartInTimeFrame(start, end).size());
+}
+
+void CharmDataModelBenchmarks::eventsThatStartInTimeFrameIndexed_data()
+{
+    addEventCountColumn();
+}
+
+void CharmDataModelBenchmarks::eventsThatStartInTimeFrameIndexed()
+{
+    QFETCH(int, eventCount);
+    CharmDataModel model;
+    model.setAllEvents(generateEvents(eventCount));
+    const QDate start = ReferenceDateTime.date().addDays(-7);
+    const QDate end = ReferenceDateTime.date();
+    EventIdList result;
+    QBENCHMARK {
+        result = model.eventsThatStartInTimeFrame(start, end);
+    }
+    QVERIFY(!result.isEmpty());
+}
+
+void CharmDataModelBenchmarks::eventStorageFootprint()
+{
+    // compares the heap usage per event of the previous layout (std::map of events
+    // with QDateTime members) and of EventStore, for events as loaded from the database:
+    if (allocatedBytes() < 0)
+        QSKIP("Heap statistics are not available on this platform");
+
+    const int eventCount = 100000;
+    const EventList events = generateEvents(eventCount);
+    // comments read from the database are separate strings, even if equal:
+    auto commentFor = [](int i) {
+        return QStringLiteral("Comment %1").arg(i % 20);
+    };
+
+    qint64 before = allocatedBytes();
+    {
+        std::map<EventId, LegacyEvent> legacy;
+        for (int i = 0; i < eventCount; ++i) {
+            const Event &event = events.at(i);
+            LegacyEvent &stored = legacy[event.id()];
+            stored.id = event.id();
+            stored.taskId = event.taskId();
+            stored.comment = commentFor(i);
+            stored.start = event.startDateTime();
+            stored.end = event.endDateTime();
+        }
+        const qint64 bytes = allocatedBytes() - before;
+        qDebug() << "legacy event map:" << bytes / eventCount << "bytes per event";
+    }
+
+    before = allocatedBytes();
+    {
+        EventStore store;
+        store.reserve(eventCount);
+        for (int i = 0; i < eventCount; ++i) {
+            Event event = events.at(i);
+            event.setComment(commentFor(i));
+            store.insert(event);
+        }
+        const qint64 bytes = allocatedBytes() - before;
+        qDebug() << "event store:" << bytes / eventCount << "bytes per event";
+        QCOMPARE(store.size(), eventCount);
+    }
+}
+
+void CharmDataModelBenchmarks::taskViewRepaint_data()
+{
+    QTest::addColumn<int>("activeEventCount");
+    QTest::newRow("1 active") << 1;
+    QTest::newRow("10 active") << 10;
+    QTest::newRow("100 active") << 100;
+}
+
+void CharmDataModelBenchmarks::taskViewRepaint()
+{
+    // repaints all rows of an expanded task view of 10k tasks. The delegate asks
+    // TaskModelAdapter::data() for these roles, and every call looks up the
+    // active event of the task:
+    QFETCH(int, activeEventCount);
+    const int taskCount = 10000;
+    CharmDataModel model;
+    model.setAllTasks(generateTasks(taskCount));
+    EventList events;
+    for (int i = 0; i < activeEventCount; ++i) {
+        Event event;
+        event.setId(i + 1);
+        event.setTaskId(taskCount - i);
+        event.setStartDateTime(QDateTime::currentDateTime());
+        events << event;
+    }
+    model.setAllEvents(events);
+    Q_FOREACH (const Event &event, events)
+        QVERIFY(model.activateEvent(event));
+    TaskModelAdapter adapter(&model);
+
+    const int roles[] = {
+        Qt::CheckStateRole, Qt::DisplayRole, Qt::DecorationRole, TasksViewRole_RunningTime
+    };
+    int active = 0;
+    QBENCHMARK {
+        active = 0;
+        QList<QModelIndex> stack;
+        stack << QModelIndex();
+        while (!stack.isEmpty()) {
+            const QModelIndex parent = stack.takeLast();
+            const int rowCount = adapter.rowCount(parent);
+            for (int row = 0; row < rowCount; ++row) {
+                const QModelIndex index = adapter.index(row, 0, parent);
+                for (int role : roles) {
+                    const QVariant value = adapter.data(index, role);
+                    if (role == Qt::DecorationRole && !value.isNull())
+                        ++active;
+                }
+                stack << index;
+            }
+        }
+    }
+    QCOMPARE(active, activeEventCount);
+    model.endAllEventsRequested();
+}
+
+void CharmDataModelBenchmarks::weeklyDurationLookups_data()
+{
+    QTest::addColumn<int>("eventCount");
+    QTest::newRow("10k events") << 10000;
+    QTest::newRow("100k events") << 100000;
+    QTest::newRow("1M events") << 1000000;
+}
+
+void CharmDataModelBenchmarks::weeklyDurationLookups()
+{
+    // the weekly totals of all tasks including their subtasks, the amount of
+    // history before the week does not matter:
+    QFETCH(int, eventCount);
+    const int taskCount = 1000;
+    CharmDataModel model;
+    model.setAllTasks(generateTasks(taskCount));
+    // one event of half an hour every hour, going back from the current week:
+    const QDate monday = QDate::currentDate().addDays(1 - QDate::currentDate().dayOfWeek());
+    const QDateTime end(monday.addDays(7), QTime(0, 0));
+    EventList events;
+    events.reserve(eventCount);
+    qint64 expected = 0;
+    for (int i = 0; i < eventCount; ++i) {
+        Event event;
+        event.setId(i + 1);
+        event.setTaskId(i % taskCount + 1);
+        event.setStartDateTime(end.addSecs(-3600 * (i + 1)));
+        event.setEndDateTime(event.startDateTime().addSecs(1800));
+        if (event.startDateTime().date() >= monday)
+            expected += event.duration();
+        events << event;
+    }
+    model.setAllEvents(events);
+
+    qint64 total = 0;
+    QBENCHMARK {
+        total = 0;
+        const DurationTable &durations = model.subtreeDurations();
+        for (QDate day = monday; day < monday.addDays(7); day = day.addDays(1))
+            total += durations.entry(1, day).duration;
+    }
+    QCOMPARE(total, expected);
+}
+
+QTEST_MAIN(CharmDataModelBenchmarks)
@@ -27,10 +27,50 @@
 #include "Core/Task.h"
 #include "Core/TaskTreeItem.h"
 #include "Core/CharmDataModel.h"
+#include "Core/CharmDataModelAdapterInterface.h"
 
 #include <QtDebug>
 #include <QtTest/QtTest>
 
+#include <algorithm>
+
+namespace {
+/** Records the notifications an adapter receives from the model. */
+class RecordingAdapter : public CharmDataModelAdapterInterface
+{
+public:
+    QStringList notifications;
+
+    void resetTasks() override { notifications << QStringLiteral("resetTasks"); }
+    void taskAboutToBeAdded(TaskId, int) override {}
+    void taskAdded(TaskId id) override { notifications << QStringLiteral("taskAdded %1").arg(id); }
+    void taskModified(TaskId id) override { notifications << QStringLiteral("taskModified %1").arg(id); }
+    void taskParentChanged(TaskId, TaskId, TaskId) override {}
+    void taskAboutToBeDeleted(TaskId) override {}
+    void taskDeleted(TaskId id) override { notifications << QStringLiteral("taskDeleted %1").arg(id); }
+
+    void resetEvents() override { notifications << QStringLiteral("resetEvents"); }
+    void eventAboutToBeAdded(EventId) override {}
+    void eventAdded(EventId id) override { notifications << QStringLiteral("eventAdded %1").arg(id); }
+    void eventModified(EventId id, Event) override
+    {
+        notifications << QStringLiteral("eventModified %1").arg(id);
+    }
+    void eventsModified(const EventIdList &ids) override
+    {
+        QStringList list;
+        Q_FOREACH (EventId id, ids)
+            list << QString::number(id);
+        notifications << QStringLiteral("eventsModified %1").arg(list.join(QLatin1Char(',')));
+    }
+    void eventAboutToBeDeleted(EventId) override {}
+    void eventDeleted(EventId id) override { notifications << QStringLiteral("eventDeleted %1").arg(id); }
+
+    void eventActivated(EventId) override {}
+    void eventDeactivated(EventId) override {}
+};
+}
+
 CharmDataModelTests::CharmDataModelTests()
     : QObject()
 {
@@ -175,6 +215,476 @@ void CharmDataModelTests::modifyTaskTest()
     QVERIFY(model.taskTreeItem(0).childCount() == 0);
 }
 
+void CharmDataModelTests::taskTreeRowsTest()
+{
+    CharmDataModel model;
+    auto verifyRows = [&model](TaskId parent, const TaskIdList &children) {
+        const TaskTreeItem &parentItem = model.taskTreeItem(parent);
+        QCOMPARE(parentItem.childCount(), children.size());
+        for (int row = 0; row < children.size(); ++row) {
+            QCOMPARE(parentItem.child(row).task().id(), children[row]);
+            QCOMPARE(parentItem.child(row).row(), row);
+            QCOMPARE(model.taskTreeItem(children[row]).row(), row);
+        }
+    };
+
+    TaskList tasks;
+    tasks << Task(1000, QStringLiteral("Task 1"))
+          << Task(1001, QStringLiteral("Task 1-1"), 1000)
+          << Task(1002, QStringLiteral("Task 1-2"), 1000)
+          << Task(1003, QStringLiteral("Task 1-3"), 1000)
+          << Task(1004, QStringLiteral("Task 1-4"), 1000)
+          << Task(2000, QStringLiteral("Task 2"));
+    model.setAllTasks(tasks);
+    verifyRows(0, TaskIdList() << 1000 << 2000);
+    verifyRows(1000, TaskIdList() << 1001 << 1002 << 1003 << 1004);
+
+    // removing a child moves the following siblings up:
+    model.deleteTask(tasks[2]);
+    verifyRows(1000, TaskIdList() << 1001 << 1003 << 1004);
+
+    // reparenting removes the child from the old parent, and appends it to the new one:
+    Task moved(tasks[1]);
+    moved.setParent(2000);
+    model.modifyTask(moved);
+    verifyRows(1000, TaskIdList() << 1003 << 1004);
+    verifyRows(2000, TaskIdList() << 1001);
+
+    model.addTask(Task(1005, QStringLiteral("Task 1-5"), 1000));
+    verifyRows(1000, TaskIdList() << 1003 << 1004 << 1005);
+
+    model.clearTasks();
+    verifyRows(0, TaskIdList());
+}
+
+void CharmDataModelTests::fullTaskNameTest()
+{
+    CharmDataModel model;
+    Task task1(1000, QStringLiteral("Task 1"));
+    Task task1_1(1001, QStringLiteral("Task 1-1"), task1.id());
+    Task task1_1_1(1011, QStringLiteral("Task 1-1-1"), task1_1.id());
+    Task task2(2000, QStringLiteral("Task 2"));
+    model.setAllTasks(TaskList() << task1 << task1_1 << task1_1_1 << task2);
+
+    QCOMPARE(model.fullTaskName(task1_1_1), QStringLiteral("Task 1/Task 1-1/Task 1-1-1"));
+    QCOMPARE(model.taskIdAndFullNameString(task1_1_1.id()),
+             QStringLiteral("1011 Task 1/Task 1-1/Task 1-1-1"));
+
+    // renaming a task changes the names of its subtree:
+    task1.setName(QStringLiteral("Renamed"));
+    model.modifyTask(task1);
+    QCOMPARE(model.fullTaskName(task1_1_1), QStringLiteral("Renamed/Task 1-1/Task 1-1-1"));
+    QCOMPARE(model.taskIdAndFullNameString(task1_1_1.id()),
+             QStringLiteral("1011 Renamed/Task 1-1/Task 1-1-1"));
+
+    // so does moving it:
+    task1_1.setParent(task2.id());
+    model.modifyTask(task1_1);
+    QCOMPARE(model.fullTaskName(task1_1_1), QStringLiteral("Task 2/Task 1-1/Task 1-1-1"));
+    QCOMPARE(model.fullTaskName(task1), QStringLiteral("Renamed"));
+
+    // tasks that differ from the stored ones are not taken from the cache:
+    Task copy(task1_1_1);
+    copy.setName(QStringLiteral("Copy"));
+    QCOMPARE(model.fullTaskName(copy), QStringLiteral("Task 2/Task 1-1/Copy"));
+    QCOMPARE(model.fullTaskName(task1_1_1), QStringLiteral("Task 2/Task 1-1/Task 1-1-1"));
+
+    model.deleteTask(task1_1_1);
+    QCOMPARE(model.taskIdAndFullNameString(task1_1_1.id()), QStringLiteral("1011 "));
+}
+
+void CharmDataModelTests::batchTest()
+{
+    CharmDataModel model;
+    RecordingAdapter adapter;
+    model.registerAdapter(&adapter);
+    Task task1(1000, QStringLiteral("Task 1"));
+    Task task2(2000, QStringLiteral("Task 2"));
+    model.setAllTasks(TaskList() << task1 << task2);
+    EventList events;
+    for (EventId id = 1; id <= 5; ++id) {
+        Event event;
+        event.setId(id);
+        event.setTaskId(id % 2 ? task1.id() : task2.id());
+        events << event;
+    }
+    model.setAllEvents(events);
+    adapter.notifications.clear();
+
+    // without a batch, every change is sent:
+    model.modifyEvent(events[0]);
+    model.modifyEvent(events[1]);
+    QCOMPARE(adapter.notifications, QStringList() << QStringLiteral("eventModified 1")
+                                                  << QStringLiteral("eventModified 2"));
+    adapter.notifications.clear();
+
+    // modifications are sent once per task and event when the batch ends:
+    {
+        const CharmDataModel::Batch batch(&model);
+        model.modifyEvent(events[3]);
+        model.modifyEvent(events[1]);
+        model.modifyEvent(events[3]);
+        task1.setName(QStringLiteral("Renamed"));
+        model.modifyTask(task1);
+        model.modifyTask(task1);
+        // nested batches are part of the outer one:
+        model.beginBatch();
+        model.modifyEvent(events[4]);
+        model.endBatch();
+        QVERIFY(adapter.notifications.isEmpty());
+    }
+    QCOMPARE(adapter.notifications, QStringList() << QStringLiteral("taskModified 1000")
+                                                  << QStringLiteral("eventsModified 4,2,5"));
+    adapter.notifications.clear();
+
+    // added or deleted events reset the adapters:
+    model.beginBatch();
+    Event added;
+    added.setId(6);
+    added.setTaskId(task2.id());
+    model.addEvent(added);
+    model.modifyEvent(added);
+    model.deleteEvent(events[2]);
+    Task task3(3000, QStringLiteral("Task 3"));
+    model.addTask(task3);
+    QVERIFY(adapter.notifications.isEmpty());
+    model.endBatch();
+    QCOMPARE(adapter.notifications, QStringList() << QStringLiteral("resetTasks")
+                                                  << QStringLiteral("resetEvents"));
+    QVERIFY(model.eventForId(6).isValid());
+    QVERIFY(!model.eventForId(3).isValid());
+    QVERIFY(model.taskTreeItem(task3.id()).isValid());
+
+    model.unregisterAdapter(&adapter);
+}
+
+void CharmDataModelTests::activeEventsTest()
+{
+    CharmDataModel model;
+    Task task1(1000, QStringLiteral("Task 1"));
+    Task task2(2000, QStringLiteral("Task 2"));
+    model.setAllTasks(TaskList() << task1 << task2);
+    Event event1;
+    event1.setId(1);
+    event1.setTaskId(task1.id());
+    event1.setStartDateTime(QDateTime::currentDateTime());
+    Event event2(event1);
+    event2.setId(2);
+    model.setAllEvents(EventList() << event1 << event2);
+
+    QVERIFY(model.activateEvent(event1));
+    QVERIFY(model.isTaskActive(task1.id()));
+    QVERIFY(!model.isTaskActive(task2.id()));
+    QVERIFY(model.isEventActive(event1.id()));
+    QCOMPARE(model.activeEventFor(task1.id()).id(), event1.id());
+    QVERIFY(!model.activeEventFor(task2.id()).isValid());
+    QCOMPARE(model.activeEventCount(), 1);
+
+    // moving the active event to another task:
+    event1.setTaskId(task2.id());
+    model.modifyEvent(event1);
+    QVERIFY(!model.isTaskActive(task1.id()));
+    QCOMPARE(model.activeEventFor(task2.id()).id(), event1.id());
+
+    model.endEventRequested(task2);
+    QVERIFY(!model.isTaskActive(task2.id()));
+    QVERIFY(!model.isEventActive(event1.id()));
+    QCOMPARE(model.activeEventCount(), 0);
+
+    QVERIFY(model.activateEvent(event2));
+    QVERIFY(model.isTaskActive(task1.id()));
+    model.endAllEventsRequested();
+    QVERIFY(!model.isTaskActive(task1.id()));
+    QVERIFY(model.activeEvents().isEmpty());
+}
+
+void CharmDataModelTests::snapshotTest()
+{
+    CharmDataModel model;
+    Task task1(1000, QStringLiteral("Task 1"));
+    Task task1_1(1001, QStringLiteral("Task 1-1"), task1.id());
+    model.setAllTasks(TaskList() << task1 << task1_1);
+    const QDateTime start(QDate(2019, 1, 7), QTime(8, 0));
+    Event event1;
+    event1.setId(1);
+    event1.setTaskId(task1_1.id());
+    event1.setStartDateTime(start);
+    event1.setEndDateTime(start.addSecs(3600));
+    model.setAllEvents(EventList() << event1);
+
+    const CharmDataModelSnapshot snapshot = model.snapshot();
+    QCOMPARE(snapshot.generation(), model.generation());
+    QCOMPARE(snapshot.getTask(task1_1.id()), task1_1);
+    QCOMPARE(snapshot.fullTaskName(task1_1), QStringLiteral("Task 1/Task 1-1"));
+    QVERIFY(snapshot.isParentOf(task1.id(), task1_1.id()));
+    QVERIFY(!snapshot.isParentOf(task1_1.id(), task1.id()));
+    QCOMPARE(snapshot.eventForId(event1.id()), event1);
+    QCOMPARE(snapshot.eventsForTask(task1_1.id()), EventIdList() << event1.id());
+    QCOMPARE(snapshot.eventsThatStartInTimeFrame(start.date(), start.date().addDays(1)),
+             EventIdList() << event1.id());
+
+    QCOMPARE(snapshot.durations().entry(task1_1.id(), start.date()).duration, 3600);
+
+    // without changes, the data is shared:
+    const CharmDataModelSnapshot unchanged = model.snapshot();
+    QCOMPARE(unchanged.generation(), snapshot.generation());
+    QCOMPARE(&unchanged.eventForId(event1.id()), &snapshot.eventForId(event1.id()));
+
+    // changes of the model do not affect existing snapshots:
+    Event event2(event1);
+    event2.setId(2);
+    event2.setTaskId(task1.id());
+    model.addEvent(event2);
+    task1.setName(QStringLiteral("Renamed"));
+    model.modifyTask(task1);
+    QVERIFY(model.generation() > snapshot.generation());
+    QVERIFY(!snapshot.eventForId(event2.id()).isValid());
+    QCOMPARE(snapshot.eventCount(), 1);
+    QCOMPARE(snapshot.fullTaskName(task1_1), QStringLiteral("Task 1/Task 1-1"));
+
+    const CharmDataModelSnapshot changed = model.snapshot();
+    QCOMPARE(changed.eventCount(), 2);
+    QCOMPARE(changed.eventForId(event2.id()), event2);
+    QCOMPARE(changed.fullTaskName(task1_1), QStringLiteral("Renamed/Task 1-1"));
+    QCOMPARE(changed.eventsThatStartInTimeFrame(start.date(), start.date().addDays(1)),
+             EventIdList() << event1.id() << event2.id());
+    QCOMPARE(changed.durations().total(task1_1.id(), start.date(), start.date().addDays(7)).eventCount,
+             1);
+
+    // the events of months without changes are shared between snapshots:
+    Event event3(event1);
+    event3.setId(3);
+    event3.setStartDateTime(start.addMonths(-2));
+    event3.setEndDateTime(start.addMonths(-2).addSecs(600));
+    model.addEvent(event3);
+    const CharmDataModelSnapshot older = model.snapshot();
+    Event modified(event3);
+    modified.setComment(QStringLiteral("Modified"));
+    model.modifyEvent(modified);
+    const CharmDataModelSnapshot modifiedSnapshot = model.snapshot();
+    QCOMPARE(&modifiedSnapshot.eventForId(event1.id()), &older.eventForId(event1.id()));
+    QCOMPARE(older.eventForId(event3.id()).comment(), QString());
+    QCOMPARE(modifiedSnapshot.eventForId(event3.id()), modified);
+    QCOMPARE(modifiedSnapshot.eventsForTask(task1_1.id()),
+             EventIdList() << event3.id() << event1.id());
+
+    // deleted events are removed from their block:
+    model.deleteEvent(modified);
+    const CharmDataModelSnapshot deleted = model.snapshot();
+    QVERIFY(!deleted.eventForId(event3.id()).isValid());
+    QCOMPARE(deleted.eventCount(), 2);
+    QCOMPARE(deleted.eventsForTask(task1_1.id()), EventIdList() << event1.id());
+}
+
+void CharmDataModelTests::eventsThatStartInTimeFrameTest()
+{
+    const QDate monday(2019, 1, 7);
+    EventList events;
+    for (int i = 0; i < 10; ++i) {
+        Event event;
+        event.setId(i + 1);
+        event.setTaskId(1000);
+        // one event per day, at noon, starting on the Monday before:
+        const QDateTime start(monday.addDays(i - 7), QTime(12, 0));
+        event.setStartDateTime(start);
+        event.setEndDateTime(start.addSecs(3600));
+        events << event;
+    }
+    Event noStart;
+    noStart.setId(11);
+    noStart.setTaskId(1000);
+    events << noStart;
+
+    CharmDataModel model;
+    model.setAllEvents(events);
+    QCOMPARE(model.eventsThatStartInTimeFrame(monday, monday.addDays(7)),
+             EventIdList() << 8 << 9 << 10);
+    QCOMPARE(model.eventsThatStartInTimeFrame(monday.addDays(-7), monday.addDays(-5)),
+             EventIdList() << 1 << 2);
+    QVERIFY(model.eventsThatStartInTimeFrame(monday, monday).isEmpty());
+
+    // moving an event updates the index:
+    Event moved = model.eventForId(1);
+    moved.setStartDateTime(QDateTime(monday.addDays(1), QTime(8, 0)));
+    model.modifyEvent(moved);
+    QCOMPARE(model.eventsThatStartInTimeFrame(monday, monday.addDays(7)),
+             EventIdList() << 8 << 1 << 9 << 10);
+    QCOMPARE(model.eventsThatStartInTimeFrame(monday.addDays(-7), monday.addDays(-5)),
+             EventIdList() << 2);
+
+    // so do deleting and adding events:
+    model.deleteEvent(model.eventForId(9));
+    Event added;
+    added.setId(12);
+    added.setTaskId(1000);
+    added.setStartDateTime(QDateTime(monday, QTime(0, 0)));
+    model.addEvent(added);
+    QCOMPARE(model.eventsThatStartInTimeFrame(monday, monday.addDays(7)),
+             EventIdList() << 12 << 8 << 1 << 10);
+
+    model.clearEvents();
+    QVERIFY(model.eventsThatStartInTimeFrame(monday, monday.addDays(7)).isEmpty());
+}
+
+void CharmDataModelTests::subtreeQueriesTest()
+{
+    CharmDataModel model;
+    Task task1(1000, QStringLiteral("Task 1"));
+    Task task1_1(1001, QStringLiteral("Task 1-1"), task1.id());
+    Task task2(2000, QStringLiteral("Task 2"));
+    Task task2_1(2100, QStringLiteral("Task 2-1"), task2.id());
+    Task task2_1_1(2110, QStringLiteral("Task 2-1-1"), task2_1.id());
+    model.setAllTasks(TaskList() << task1 << task1_1 << task2 << task2_1 << task2_1_1);
+
+    QVERIFY(model.isParentOf(task1.id(), task1_1.id()));
+    QVERIFY(model.isParentOf(task2.id(), task2_1_1.id()));
+    QVERIFY(model.isParentOf(task2_1.id(), task2_1_1.id()));
+    QVERIFY(!model.isParentOf(task2_1_1.id(), task2_1.id()));
+    QVERIFY(!model.isParentOf(task1.id(), task2_1.id()));
+    QVERIFY(!model.isParentOf(task1.id(), task1.id()));
+
+    const TaskId taskIds[] = { task1.id(), task1_1.id(), task2_1.id(), task2_1_1.id() };
+    EventList events;
+    for (int i = 0; i < 4; ++i) {
+        Event event;
+        event.setId(i + 1);
+        event.setTaskId(taskIds[i]);
+        // one event per day, from Monday to Thursday:
+        event.setStartDateTime(QDateTime(QDate(2019, 1, 7 + i), QTime(10, 0)));
+        event.setEndDateTime(QDateTime(QDate(2019, 1, 7 + i), QTime(11, 0)));
+        events << event;
+    }
+    model.setAllEvents(events);
+
+    QCOMPARE(model.eventsForTask(task2_1.id()), EventIdList() << 3);
+    QVERIFY(model.eventsForTask(task2.id()).isEmpty());
+    EventIdList subtree = model.eventsInSubtree(task2.id());
+    std::sort(subtree.begin(), subtree.end());
+    QCOMPARE(subtree, EventIdList() << 3 << 4);
+
+    // moving a subtree updates the numbering:
+    Task task2_1b(task2_1);
+    task2_1b.setParent(task1_1.id());
+    model.modifyTask(task2_1b);
+    QVERIFY(model.isParentOf(task1.id(), task2_1_1.id()));
+    QVERIFY(model.isParentOf(task1_1.id(), task2_1.id()));
+    QVERIFY(!model.isParentOf(task2.id(), task2_1_1.id()));
+    QVERIFY(model.eventsInSubtree(task2.id()).isEmpty());
+    subtree = model.eventsInSubtree(task1.id());
+    std::sort(subtree.begin(), subtree.end());
+    QCOMPARE(subtree, EventIdList() << 1 << 2 << 3 << 4);
+    subtree = model.eventsInSubtree(task1.id(), QDate(2019, 1, 8), QDate(2019, 1, 10));
+    std::sort(subtree.begin(), subtree.end());
+    QCOMPARE(subtree, EventIdList() << 2 << 3);
+    QVERIFY(model.eventsInSubtree(task1.id(), QDate(2019, 1, 10), QDate(2019, 1, 10)).isEmpty());
+
+    // moving an event to another task updates the task index:
+    Event event = model.eventForId(4);
+    event.setTaskId(task2.id());
+    model.modifyEvent(event);
+    QCOMPARE(model.eventsForTask(task2.id()), EventIdList() << 4);
+    QVERIFY(model.eventsForTask(task2_1_1.id()).isEmpty());
+}
+
+void CharmDataModelTests::taskUsageRankingsTest()
+{
+    const QDateTime reference(QDate(2019, 1, 7), QTime(12, 0));
+    // task 1 is used three times, tasks 2 and 3 twice, task 4 once, most recently:
+    const TaskId taskIds[] = { 1, 2, 3, 1, 2, 3, 1, 4 };
+    EventList events;
+    for (int i = 0; i < 8; ++i) {
+        Event event;
+        event.setId(i + 1);
+        event.setTaskId(taskIds[i]);
+        event.setStartDateTime(reference.addSecs(i * 3600));
+        events << event;
+    }
+
+    CharmDataModel model;
+    model.setAllEvents(events);
+    // tasks with equal counts are all listed:
+    QCOMPARE(model.mostFrequentlyUsedTasks(), TaskIdList() << 1 << 2 << 3 << 4);
+    QCOMPARE(model.mostRecentlyUsedTasks(), TaskIdList() << 4 << 1 << 3 << 2);
+    QCOMPARE(model.mostRecentlyUsedTasks(2), TaskIdList() << 4 << 1);
+    QVERIFY(model.mostRecentlyUsedTasks(0).isEmpty());
+
+    // the rankings follow modifications:
+    Event event = model.eventForId(2);
+    event.setTaskId(4);
+    event.setStartDateTime(reference.addDays(1));
+    model.modifyEvent(event);
+    QCOMPARE(model.mostFrequentlyUsedTasks(), TaskIdList() << 1 << 3 << 4 << 2);
+    QCOMPARE(model.mostRecentlyUsedTasks(), TaskIdList() << 4 << 1 << 3 << 2);
+
+    model.deleteEvent(model.eventForId(5));
+    QCOMPARE(model.mostFrequentlyUsedTasks(), TaskIdList() << 1 << 3 << 4);
+    QCOMPARE(model.mostRecentlyUsedTasks(), TaskIdList() << 4 << 1 << 3);
+
+    model.clearEvents();
+    QVERIFY(model.mostFrequentlyUsedTasks().isEmpty());
+    QVERIFY(model.mostRecentlyUsedTasks().isEmpty());
+}
+
+void CharmDataModelTests::eventStoreTest()
+{
+    const QDateTime start(QDate(2019, 3, 4), QTime(9, 0), Qt::UTC);
+    auto makeEvent = [&](EventId id, int hour) {
+        Event event;
+        event.setId(id);
+        event.setTaskId(1);
+        event.setComment(QStringLiteral("Meeting"));
+        event.setStartDateTime(start.addSecs(hour * 3600));
+        event.setEndDateTime(start.addSecs(hour * 3600 + 1800));
+        return event;
+    };
+
+    EventStore store;
+    QVERIFY(store.isEmpty());
+    store.insert(makeEvent(1, 0));
+    store.insert(makeEvent(2, 1));
+    store.insert(makeEvent(3, 2));
+    QCOMPARE(store.size(), 3);
+    QVERIFY(store.contains(2));
+    QCOMPARE(store.find(2)->startSecsSinceEpoch(), start.addSecs(3600).toSecsSinceEpoch());
+    QCOMPARE(store.find(2)->startDateTime(Qt::UTC), start.addSecs(3600));
+    QCOMPARE(store.find(2)->duration(), 1800);
+
+    // replacing an event keeps its address:
+    const Event *second = store.find(2);
+    Event modified = makeEvent(2, 5);
+    modified.setComment(QStringLiteral("Review"));
+    store.insert(modified);
+    QCOMPARE(store.size(), 3);
+    QCOMPARE(store.find(2), second);
+    QCOMPARE(*store.find(2), modified);
+
+    // removed events are skipped by iteration, their slots are reused:
+    QVERIFY(store.remove(1));
+    QVERIFY(!store.remove(1));
+    QVERIFY(!store.contains(1));
+    QVERIFY(store.find(1) == nullptr);
+    EventIdList ids;
+    for (const Event &event : store)
+        ids << event.id();
+    std::sort(ids.begin(), ids.end());
+    QCOMPARE(ids, EventIdList() << 2 << 3);
+    store.insert(makeEvent(4, 3));
+    QCOMPARE(store.size(), 3);
+    QVERIFY(store.contains(4));
+
+    // equality does not depend on the insertion order:
+    EventStore other;
+    other.insert(makeEvent(4, 3));
+    other.insert(makeEvent(3, 2));
+    QVERIFY(store != other);
+    other.insert(modified);
+    QVERIFY(store == other);
+
+    store.clear();
+    QVERIFY(store.isEmpty());
+    QVERIFY(store.begin() == store.end());
+}
+
 void CharmDataModelTests::cleanupTestCase()
 {
     m_referenceModel->clearTasks();
@@ -184,4 +694,216 @@ void CharmDataModelTests::cleanupTestCase()
     m_referenceModel = nullptr;
 }
 
+void CharmDataModelTests::changeJournalTest()
+{
+    CharmDataModel model;
+    Task task1(1000, QStringLiteral("Task 1"));
+    model.setAllTasks(TaskList() << task1);
+    const quint64 start = model.generation();
+    QCOMPARE(model.taskGeneration(), start);
+
+    CharmDataModel::ChangeList changes;
+    QVERIFY(model.changesSince(start, &changes));
+    QVERIFY(changes.isEmpty());
+    QVERIFY(!model.changesSince(start + 1, &changes));
+
+    Task task2(1001, QStringLiteral("Task 2"));
+    model.addTask(task2);
+    task1.setName(QStringLiteral("Renamed"));
+    model.modifyTask(task1);
+    Event event;
+    event.setId(1);
+    event.setTaskId(task2.id());
+    model.addEvent(event);
+    QCOMPARE(model.generation(), start + 3);
+    QCOMPARE(model.taskGeneration(), start + 2);
+    QCOMPARE(model.eventGeneration(), start + 3);
+
+    QVERIFY(model.changesSince(start, &changes));
+    QCOMPARE(changes.size(), 3);
+    QCOMPARE(changes[0].kind, CharmDataModel::Change::TaskAdded);
+    QCOMPARE(changes[0].id, task2.id());
+    QCOMPARE(changes[0].generation, start + 1);
+    QCOMPARE(changes[1].kind, CharmDataModel::Change::TaskModified);
+    QCOMPARE(changes[1].id, task1.id());
+    QCOMPARE(changes[2].kind, CharmDataModel::Change::EventAdded);
+    QCOMPARE(changes[2].id, event.id());
+
+    QVERIFY(model.changesSince(start + 2, &changes));
+    QCOMPARE(changes.size(), 1);
+    QCOMPARE(changes[0].kind, CharmDataModel::Change::EventAdded);
+
+    // old changes are dropped from the journal:
+    for (int i = 0; i < 2000; ++i)
+        model.modifyEvent(event);
+    QVERIFY(!model.changesSince(start, &changes));
+    QVERIFY(model.changesSince(model.generation() - 10, &changes));
+    QCOMPARE(changes.size(), 10);
+    QCOMPARE(changes.last().generation, model.generation());
+}
+
+void CharmDataModelTests::durationsTest()
+{
+    CharmDataModel model;
+    Task task1(1000, QStringLiteral("Task 1"));
+    Task task1_1(1001, QStringLiteral("Task 1-1"), task1.id());
+    Task task2(2000, QStringLiteral("Task 2"));
+    model.setAllTasks(TaskList() << task1 << task1_1 << task2);
+
+    const QDate monday(2019, 1, 7);
+    const QDate tuesday = monday.addDays(1);
+    Event event1;
+    event1.setId(1);
+    event1.setTaskId(task1.id());
+    event1.setStartDateTime(QDateTime(monday, QTime(8, 0)));
+    event1.setEndDateTime(QDateTime(monday, QTime(9, 0)));
+    Event event2(event1);
+    event2.setId(2);
+    event2.setTaskId(task1_1.id());
+    Event event3(event1);
+    event3.setId(3);
+    event3.setStartDateTime(QDateTime(tuesday, QTime(8, 0)));
+    event3.setEndDateTime(QDateTime(tuesday, QTime(8, 30)));
+    model.setAllEvents(EventList() << event1 << event2);
+    model.addEvent(event3);
+
+    const DurationTable &durations = model.durations();
+    QCOMPARE(durations.entry(task1.id(), monday).duration, 3600);
+    QCOMPARE(durations.entry(task1.id(), monday).eventCount, 1);
+    QCOMPARE(durations.entry(task1.id(), tuesday).duration, 1800);
+    QCOMPARE(durations.entry(task1_1.id(), monday).duration, 3600);
+    QCOMPARE(durations.total(task1.id(), monday, monday.addDays(7)).duration, 5400);
+    QCOMPARE(durations.total(task1.id(), tuesday, monday.addDays(7)).duration, 1800);
+    QCOMPARE(durations.tasksInTimeFrame(monday, tuesday), TaskIdList() << task1.id() << task1_1.id());
+    QCOMPARE(model.subtreeDurations().entry(task1.id(), monday).duration, 7200);
+    QCOMPARE(model.subtreeDurations().entry(task1.id(), monday).eventCount, 2);
+
+    // modifications update both tables:
+    event2.setEndDateTime(QDateTime(monday, QTime(10, 0)));
+    model.modifyEvent(event2);
+    QCOMPARE(durations.entry(task1_1.id(), monday).duration, 7200);
+    QCOMPARE(model.subtreeDurations().entry(task1.id(), monday).duration, 10800);
+    event2.setStartDateTime(QDateTime(tuesday, QTime(8, 0)));
+    event2.setEndDateTime(QDateTime(tuesday, QTime(9, 0)));
+    model.modifyEvent(event2);
+    QCOMPARE(durations.entry(task1_1.id(), monday).eventCount, 0);
+    QCOMPARE(durations.entry(task1_1.id(), tuesday).duration, 3600);
+    QCOMPARE(model.subtreeDurations().entry(task1.id(), tuesday).duration, 5400);
+    model.deleteEvent(event3);
+    QCOMPARE(durations.entry(task1.id(), tuesday).eventCount, 0);
+    QCOMPARE(model.subtreeDurations().entry(task1.id(), tuesday).duration, 3600);
+
+    // moving a task moves its durations to the new parent:
+    task1_1.setParent(task2.id());
+    model.modifyTask(task1_1);
+    QCOMPARE(model.subtreeDurations().entry(task1.id(), tuesday).duration, 0);
+    QCOMPARE(model.subtreeDurations().entry(task2.id(), tuesday).duration, 3600);
+    QCOMPARE(model.subtreeDurations().entry(task1_1.id(), tuesday).duration, 3600);
+
+    model.clearEvents();
+    QVERIFY(model.durations().isEmpty());
+    QVERIFY(model.subtreeDurations().isEmpty());
+}
+
+void CharmDataModelTests::eventWindowTest()
+{
+    CharmDataModel model;
+    Task task1(1000, QStringLiteral("Task 1"));
+    model.setAllTasks(TaskList() << task1);
+
+    // one event on the first day of every month of two years:
+    const QDate windowStart(2019, 1, 1);
+    EventList stored;
+    for (int i = 0; i < 24; ++i) {
+        Event event;
+        event.setId(i + 1);
+        event.setTaskId(task1.id());
+        event.setStartDateTime(QDateTime(QDate(2017, 1, 1).addMonths(i), QTime(8, 0)));
+        event.setEndDateTime(event.startDateTime().addSecs(3600));
+        stored << event;
+    }
+    Event recent(stored.first());
+    recent.setId(100);
+    recent.setStartDateTime(QDateTime(windowStart, QTime(8, 0)));
+    recent.setEndDateTime(QDateTime(windowStart, QTime(9, 0)));
+    stored << recent;
+
+    // the storage, like Controller::provideEventsInRange():
+    QList<QPair<QDate, QDate> > requests;
+    connect(&model, &CharmDataModel::eventsRequested,
+            [&](const QDate &start, const QDate &end) {
+        requests << qMakePair(start, end);
+        EventList events;
+        Q_FOREACH (const Event &event, stored) {
+            const QDate day = event.startDateTime().date();
+            if ((!start.isValid() || day >= start) && day < end)
+                events << event;
+        }
+        model.addLoadedEvents(events);
+    });
+
+    model.setRecentEvents(EventList() << recent, windowStart);
+    QCOMPARE(model.eventWindowStart(), windowStart);
+    QCOMPARE(model.eventStore().size(), 1);
+
+    // the recent events are always there:
+    model.requireEvents(windowStart, windowStart.addDays(7));
+    QVERIFY(requests.isEmpty());
+
+    // older months are loaded once:
+    const QDate march2018(2018, 3, 1);
+    model.requireEvents(march2018.addDays(5), march2018.addMonths(1));
+    QCOMPARE(requests.size(), 1);
+    QCOMPARE(requests.first(), qMakePair(march2018, march2018.addMonths(1)));
+    QCOMPARE(model.eventsThatStartInTimeFrame(march2018, march2018.addMonths(1)).size(), 1);
+    model.requireEvents(march2018, march2018.addDays(1));
+    QCOMPARE(requests.size(), 1);
+
+    // the least recently used months are unloaded:
+    const quint64 beforeUnload = model.generation();
+    for (int i = 0; i < 12; ++i)
+        model.requireEvents(QDate(2017, 1, 1).addMonths(i), QDate(2017, 1, 2).addMonths(i));
+    QCOMPARE(requests.size(), 13);
+    QCOMPARE(model.eventStore().size(), 13);
+    QVERIFY(!model.eventForId(stored[14].id()).isValid());
+    QVERIFY(model.eventForId(stored[11].id()).isValid());
+
+    // unloading is not journaled as a deletion:
+    CharmDataModel::ChangeList changes;
+    QVERIFY(model.changesSince(beforeUnload, &changes));
+    int unloaded = 0;
+    Q_FOREACH (const CharmDataModel::Change &change, changes) {
+        QVERIFY(change.kind != CharmDataModel::Change::EventDeleted);
+        if (change.kind == CharmDataModel::Change::EventUnloaded) {
+            QCOMPARE(change.id, stored[14].id());
+            ++unloaded;
+        }
+    }
+    QCOMPARE(unloaded, 1);
+
+    // changes of unloaded events are ignored, e.g. undoing a modification:
+    Event modified(stored[14]);
+    modified.setComment(QStringLiteral("Modified"));
+    model.modifyEvent(modified);
+    QVERIFY(!model.eventForId(modified.id()).isValid());
+    model.deleteEvent(modified);
+    QCOMPARE(model.eventStore().size(), 13);
+
+    // events of loaded months that are not in the model yet are added:
+    Event added(stored[11]);
+    added.setId(200);
+    model.modifyEvent(added);
+    QCOMPARE(model.eventForId(added.id()), added);
+    model.deleteEvent(added);
+    QCOMPARE(model.eventStore().size(), 13);
+
+    // large time spans load all events:
+    model.requireEvents(QDate(2000, 1, 1), windowStart);
+    QVERIFY(!model.eventWindowStart().isValid());
+    QCOMPARE(requests.last(), qMakePair(QDate(), windowStart));
+    QCOMPARE(model.eventStore().size(), stored.size());
+    model.requireEvents(QDate(), QDate());
+    QCOMPARE(requests.size(), 14);
+}
+
 QTEST_MAIN(CharmDataModelTests)
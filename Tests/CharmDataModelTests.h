@@ -40,6 +40,18 @@ private Q_SLOTS:
     void createAndDestroyTest();
     void addAndRemoveTasksTest();
     void modifyTaskTest();
+    void taskTreeRowsTest();
+    void fullTaskNameTest();
+    void batchTest();
+    void activeEventsTest();
+    void snapshotTest();
+    void changeJournalTest();
+    void durationsTest();
+    void eventWindowTest();
+    void eventsThatStartInTimeFrameTest();
+    void subtreeQueriesTest();
+    void taskUsageRankingsTest();
+    void eventStoreTest();
     void cleanupTestCase();
 
 private:
@@ -35,6 +35,8 @@
 #include <QtDebug>
 #include <QtTest/QtTest>
 
+#include <algorithm>
+
 ControllerTests::ControllerTests()
     : QObject()
     , m_configuration(Configuration::instance())
@@ -265,6 +267,46 @@ void ControllerTests::toAndFromXmlTest()
     QDomDocument document2 = m_controller->exportDatabasetoXml();
 }
 
+void ControllerTests::setAllTasksTest()
+{
+    auto sortedById = [](TaskList tasks) {
+        std::sort(tasks.begin(), tasks.end(), Task::lowerTaskId);
+        return tasks;
+    };
+    const TaskList tasksBefore = sortedById(m_controller->storage()->getAllTasks());
+    QVERIFY(tasksBefore.size() == 2);
+    QCOMPARE(sortedById(m_definedTasks), tasksBefore);
+    m_taskListReceived = false;
+
+    // add a child task and rename its parent, the view receives only the changes:
+    TaskList tasks = tasksBefore;
+    Task &parent = tasks.last();
+    const bool parentSubscribed = parent.subscribed();
+    parent.setName(QStringLiteral("Renamed"));
+    parent.setSubscribed(!parentSubscribed);   // subscriptions are not changed by setAllTasks
+    Task child;
+    child.setId(parent.id() + 1);
+    child.setName(QStringLiteral("Child"));
+    child.setParent(parent.id());
+    tasks << child;
+    QVERIFY(m_controller->setAllTasks(tasks));
+    QVERIFY(!m_taskListReceived);
+    tasks[1].setSubscribed(parentSubscribed);
+    QCOMPARE(sortedById(m_definedTasks), sortedById(tasks));
+    QCOMPARE(sortedById(m_controller->storage()->getAllTasks()), sortedById(tasks));
+
+    // setting the same list again changes nothing:
+    QVERIFY(m_controller->setAllTasks(tasks));
+    QVERIFY(!m_taskListReceived);
+    QCOMPARE(sortedById(m_definedTasks), sortedById(tasks));
+
+    // go back to the previous list, this deletes the child:
+    QVERIFY(m_controller->setAllTasks(tasksBefore));
+    QVERIFY(!m_taskListReceived);
+    QCOMPARE(sortedById(m_definedTasks), tasksBefore);
+    QCOMPARE(sortedById(m_controller->storage()->getAllTasks()), tasksBefore);
+}
+
 void ControllerTests::disconnectFromBackendTest()
 {
     QVERIFY(m_controller->disconnectFromBackend());
@@ -58,6 +58,8 @@ private Q_SLOTS:
 
     void toAndFromXmlTest();
 
+    void setAllTasksTest();
+
     // this is now done by the model:
     // void startModifyEndEventTest();
 
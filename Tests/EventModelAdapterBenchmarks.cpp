@@ -0,0 +1,129 @@
+/*
+  EventModelAdapterBenchmarks.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "EventModelAdapterBenchmarks.h"
+
+#include "Charm/EventModelAdapter.h"
+#include "Core/CharmDataModel.h"
+
+#include <QtTest/QtTest>
+
+namespace {
+/** Generate @p count one hour events, one every two hours before 2019.
+ * Like in the database, later events have higher ids. */
+EventList generateEvents(int count)
+{
+    const QDateTime reference(QDate(2019, 1, 1), QTime(8, 0));
+    EventList events;
+    events.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        Event event;
+        event.setId(i + 1);
+        event.setTaskId(i % 100 + 1);
+        const QDateTime start = reference.addSecs(-qint64(count - i) * 7200);
+        event.setStartDateTime(start);
+        event.setEndDateTime(start.addSecs(3600));
+        events.append(event);
+    }
+    return events;
+}
+}
+
+void EventModelAdapterBenchmarks::modifyEvents_data()
+{
+    QTest::addColumn<int>("eventCount");
+    QTest::addColumn<int>("modifiedCount");
+    // the update timer modifies the active events every 10 seconds:
+    QTest::newRow("10k events, 10 modified") << 10000 << 10;
+    QTest::newRow("100k events, 10 modified") << 100000 << 10;
+    // bulk edits, like find and replace:
+    QTest::newRow("10k events, 1k modified") << 10000 << 1000;
+    QTest::newRow("100k events, 10k modified") << 100000 << 10000;
+}
+
+void EventModelAdapterBenchmarks::modifyEvents()
+{
+    QFETCH(int, eventCount);
+    QFETCH(int, modifiedCount);
+    CharmDataModel model;
+    EventList events = generateEvents(eventCount);
+    model.setAllEvents(events);
+    EventModelAdapter adapter(&model);
+    QCOMPARE(adapter.rowCount(), eventCount);
+
+    // modify events spread over the whole history:
+    const int step = eventCount / modifiedCount;
+    int changes = 0;
+    connect(&adapter, &QAbstractItemModel::dataChanged, [&changes]() { ++changes; });
+    QBENCHMARK {
+        for (int i = 0; i < modifiedCount; ++i) {
+            Event &event = events[i * step];
+            event.setEndDateTime(event.endDateTime().addSecs(10));
+            model.modifyEvent(event);
+        }
+    }
+    QVERIFY(changes >= modifiedCount);
+    const Event &last = events[(modifiedCount - 1) * step];
+    QCOMPARE(adapter.indexForEvent(last).row(), (modifiedCount - 1) * step);
+}
+
+void EventModelAdapterBenchmarks::deleteRecentEvents()
+{
+    // delete the newest 1000 of 100k events one by one, usually the events that are
+    // deleted are recent ones, the rows are ordered by id:
+    const int eventCount = 100000;
+    const int deletedCount = 1000;
+    const EventList events = generateEvents(eventCount);
+    CharmDataModel model;
+    model.setAllEvents(events);
+    EventModelAdapter adapter(&model);
+    QBENCHMARK_ONCE {
+        for (int i = eventCount - 1; i >= eventCount - deletedCount; --i)
+            model.deleteEvent(events[i]);
+    }
+    QCOMPARE(adapter.rowCount(), eventCount - deletedCount);
+    QCOMPARE(adapter.indexForEvent(events[0]).row(), 0);
+    QCOMPARE(adapter.indexForEvent(events[eventCount - deletedCount - 1]).row(),
+             eventCount - deletedCount - 1);
+    QVERIFY(!adapter.indexForEvent(events[eventCount - 1]).isValid());
+}
+
+void EventModelAdapterBenchmarks::deleteOldEvents()
+{
+    // delete the oldest 1000 of 100k events one by one, like when cleaning up the
+    // history. All following rows move up with every deleted row:
+    const int eventCount = 100000;
+    const int deletedCount = 1000;
+    const EventList events = generateEvents(eventCount);
+    CharmDataModel model;
+    model.setAllEvents(events);
+    EventModelAdapter adapter(&model);
+    QBENCHMARK_ONCE {
+        for (int i = 0; i < deletedCount; ++i)
+            model.deleteEvent(events[i]);
+    }
+    QCOMPARE(adapter.rowCount(), eventCount - deletedCount);
+    QCOMPARE(adapter.indexForEvent(events[deletedCount]).row(), 0);
+    QCOMPARE(adapter.indexForEvent(events[eventCount - 1]).row(), eventCount - deletedCount - 1);
+    QVERIFY(!adapter.indexForEvent(events[0]).isValid());
+}
+
+QTEST_MAIN(EventModelAdapterBenchmarks)
@@ -306,4 +306,146 @@ void EventModelFilterTests::checkEventSpanOver2Days()
     m_referenceModel->clearEvents();
 }
 
+void EventModelFilterTests::checkTimeWindowUpdates()
+{
+    Event event1, event2, event3;
+    QDateTime time = QDateTime::currentDateTime();
+    time.setDate(m_lastWeekSpan.timespan.first);
+    event1.setId(1);
+    event1.setTaskId(1000);
+    event1.setStartDateTime(time.addDays(2));
+    event1.setEndDateTime(time.addDays(2).addSecs(3600));
+    event2.setId(2);
+    event2.setTaskId(1000);
+    event2.setStartDateTime(time);
+    event2.setEndDateTime(time.addSecs(3600));
+    // outside of last week:
+    event3.setId(3);
+    event3.setTaskId(1000);
+    event3.setStartDateTime(time.addDays(-14));
+    event3.setEndDateTime(time.addDays(-14).addSecs(3600));
+
+    EventList events;
+    events << event1 << event2 << event3;
+    m_referenceModel->setAllEvents(events);
+
+    m_eventModelFilter->setFilterStartDate(m_lastWeekSpan.timespan.first);
+    m_eventModelFilter->setFilterEndDate(m_lastWeekSpan.timespan.second);
+    // the rows are in start time order:
+    QCOMPARE(m_eventModelFilter->events(), QList<Event>() << event2 << event1);
+
+    // events move within the window, and enter and leave it:
+    event2.setStartDateTime(time.addDays(3));
+    event2.setEndDateTime(time.addDays(3).addSecs(3600));
+    m_referenceModel->modifyEvent(event2);
+    QCOMPARE(m_eventModelFilter->events(), QList<Event>() << event1 << event2);
+    event3.setStartDateTime(time.addDays(1));
+    event3.setEndDateTime(time.addDays(1).addSecs(3600));
+    m_referenceModel->modifyEvent(event3);
+    QCOMPARE(m_eventModelFilter->events(), QList<Event>() << event3 << event1 << event2);
+    event1.setStartDateTime(time.addDays(14));
+    event1.setEndDateTime(time.addDays(14).addSecs(3600));
+    m_referenceModel->modifyEvent(event1);
+    QCOMPARE(m_eventModelFilter->events(), QList<Event>() << event3 << event2);
+
+    // added and deleted events:
+    Event event4(event2);
+    event4.setId(4);
+    event4.setStartDateTime(time.addDays(2));
+    event4.setEndDateTime(time.addDays(2).addSecs(3600));
+    m_referenceModel->addEvent(event4);
+    QCOMPARE(m_eventModelFilter->events(), QList<Event>() << event3 << event4 << event2);
+    m_referenceModel->deleteEvent(event3);
+    m_referenceModel->deleteEvent(event1);
+    QCOMPARE(m_eventModelFilter->events(), QList<Event>() << event4 << event2);
+
+    // an event that becomes long enough to reach into the window from before it:
+    Event event5(event2);
+    event5.setId(5);
+    event5.setStartDateTime(time.addDays(-10));
+    event5.setEndDateTime(time.addDays(-10).addSecs(3600));
+    m_referenceModel->addEvent(event5);
+    QCOMPARE(m_eventModelFilter->events(), QList<Event>() << event4 << event2);
+    event5.setEndDateTime(time.addDays(1));
+    m_referenceModel->modifyEvent(event5);
+    QCOMPARE(m_eventModelFilter->events(), QList<Event>() << event5 << event4 << event2);
+
+    m_referenceModel->clearEvents();
+}
+
+void EventModelFilterTests::checkTotals()
+{
+    Event event1, event2;
+    QDateTime time = QDateTime::currentDateTime();
+    time.setDate(m_thisWeekSpan.timespan.first);
+    event1.setId(1);
+    event1.setTaskId(1000);
+    event1.setStartDateTime(time);
+    event1.setEndDateTime(time.addSecs(3600));
+    event2.setId(2);
+    event2.setTaskId(1000);
+    event2.setStartDateTime(time.addDays(1));
+    event2.setEndDateTime(time.addDays(1).addSecs(1800));
+
+    m_referenceModel->setAllEvents(EventList() << event1);
+    m_eventModelFilter->setFilterStartDate(m_thisWeekSpan.timespan.first);
+    m_eventModelFilter->setFilterEndDate(m_thisWeekSpan.timespan.second);
+    QCOMPARE(m_eventModelFilter->totalDuration(), 3600);
+
+    m_referenceModel->addEvent(event2);
+    QCOMPARE(m_eventModelFilter->totalDuration(), 5400);
+    QCOMPARE(m_eventModelFilter->eventIds(), QSet<EventId>() << event1.id() << event2.id());
+
+    // moving an event out of the time span, but not out of the window of the source model:
+    Event moved(event2);
+    moved.setStartDateTime(QDateTime(m_thisWeekSpan.timespan.first.addDays(-1), QTime(10, 0)));
+    moved.setEndDateTime(moved.startDateTime().addSecs(1800));
+    m_referenceModel->modifyEvent(moved);
+    QCOMPARE(m_eventModelFilter->totalDuration(), 3600);
+    m_referenceModel->modifyEvent(event2);
+    QCOMPARE(m_eventModelFilter->totalDuration(), 5400);
+
+    event1.setEndDateTime(time.addSecs(7200));
+    m_referenceModel->modifyEvent(event1);
+    QCOMPARE(m_eventModelFilter->totalDuration(), 9000);
+
+    m_referenceModel->deleteEvent(event2);
+    QCOMPARE(m_eventModelFilter->totalDuration(), 7200);
+    QVERIFY(!m_eventModelFilter->containsEvent(event2.id()));
+
+    m_eventModelFilter->setFilterTaskId(2000);
+    QCOMPARE(m_eventModelFilter->totalDuration(), 0);
+    QVERIFY(m_eventModelFilter->eventIds().isEmpty());
+    m_eventModelFilter->setFilterTaskId(TaskId());
+    QCOMPARE(m_eventModelFilter->totalDuration(), 7200);
+
+    m_referenceModel->clearEvents();
+    QCOMPARE(m_eventModelFilter->totalDuration(), 0);
+}
+
+void EventModelFilterTests::checkTimeSpanLoading()
+{
+    CharmDataModel model;
+    model.setAllTasks(TaskList() << Task(1000, QStringLiteral("Task 1")));
+    EventModelFilter filter(&model);
+    QList<QPair<QDate, QDate> > requests;
+    connect(&model, &CharmDataModel::eventsRequested,
+            [&](const QDate &start, const QDate &end) {
+        requests << qMakePair(start, end);
+        model.addLoadedEvents(EventList());
+    });
+    model.setRecentEvents(EventList(), m_thisWeekSpan.timespan.first);
+
+    filter.setFilterTimeSpan(m_thisWeekSpan.timespan.first, m_thisWeekSpan.timespan.second);
+    QVERIFY(requests.isEmpty());
+
+    // switching to a month two years back only loads that month:
+    const QDate old = m_thisWeekSpan.timespan.first.addYears(-2);
+    const QDate month(old.year(), old.month(), 1);
+    filter.setFilterTimeSpan(month, month.addMonths(1));
+    QCOMPARE(requests.size(), 1);
+    QCOMPARE(requests.first(), qMakePair(month, month.addMonths(1)));
+    QCOMPARE(model.eventWindowStart(), m_thisWeekSpan.timespan.first);
+}
+
 QTEST_MAIN(EventModelFilterTests)
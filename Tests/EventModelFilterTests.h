@@ -46,6 +46,9 @@ private Q_SLOTS:
     void checkDaysFilter();
     void checkEventSpanOver2Weeks();
     void checkEventSpanOver2Days();
+    void checkTimeWindowUpdates();
+    void checkTotals();
+    void checkTimeSpanLoading();
 
 private:
     CharmDataModel *m_referenceModel = nullptr;
@@ -49,4 +49,56 @@ void SmartNameCacheTests::testCache()
     QCOMPARE(cache.smartName(lotsofcakeDevelopment.id()), QLatin1String("Lotsofcake/Development"));
 }
 
+void SmartNameCacheTests::testIncrementalUpdates()
+{
+    Task projects(1, QStringLiteral("Projects"));
+    Task charm(2, QStringLiteral("Charm"), projects.id());
+    Task charmDevelopment(3, QStringLiteral("Development"), charm.id());
+    Task lotsofcake(4, QStringLiteral("Lotsofcake"), projects.id());
+    Task lotsofcakeDevelopment(5, QStringLiteral("Development"), lotsofcake.id());
+    Task customers(6, QStringLiteral("Customers"));
+    Task charmCustomer(7, QStringLiteral("Charm"), customers.id());
+    Task customerDevelopment(8, QStringLiteral("Development"), charmCustomer.id());
+
+    // add the tasks one by one, the child before its parent:
+    SmartNameCache cache;
+    TaskList tasks = TaskList() << projects << charm << charmDevelopment << lotsofcake
+                                << lotsofcakeDevelopment << customers << customerDevelopment
+                                << charmCustomer;
+    Q_FOREACH (const Task &task, tasks)
+        cache.addTask(task);
+
+    auto verify = [&cache](const TaskList &tasks) {
+        SmartNameCache reference;
+        reference.setAllTasks(tasks);
+        Q_FOREACH (const Task &task, tasks)
+            QCOMPARE(cache.smartName(task.id()), reference.smartName(task.id()));
+    };
+    verify(tasks);
+    QCOMPARE(cache.smartName(charmDevelopment.id()),
+             QStringLiteral("Projects/Charm/Development"));
+    QCOMPARE(cache.smartName(customerDevelopment.id()),
+             QStringLiteral("Customers/Charm/Development"));
+
+    // renaming a parent task changes the names below it:
+    charmCustomer.setName(QStringLiteral("Charming"));
+    cache.modifyTask(charmCustomer);
+    tasks[7] = charmCustomer;
+    verify(tasks);
+    QCOMPARE(cache.smartName(charmDevelopment.id()), QStringLiteral("Charm/Development"));
+    QCOMPARE(cache.smartName(customerDevelopment.id()), QStringLiteral("Charming/Development"));
+
+    // moving a task:
+    customerDevelopment.setParent(lotsofcake.id());
+    cache.modifyTask(customerDevelopment);
+    tasks[6] = customerDevelopment;
+    verify(tasks);
+
+    cache.deleteTask(customerDevelopment);
+    tasks.removeAt(6);
+    verify(tasks);
+    QCOMPARE(cache.smartName(customerDevelopment.id()), QString());
+    QCOMPARE(cache.smartName(lotsofcakeDevelopment.id()), QStringLiteral("Lotsofcake/Development"));
+}
+
 QTEST_MAIN(SmartNameCacheTests)
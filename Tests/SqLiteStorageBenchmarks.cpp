@@ -0,0 +1,420 @@
+/*
+  SqLiteStorageBenchmarks.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SqLiteStorageBenchmarks.h"
+
+#include "Core/CharmConstants.h"
+#include "Core/SqlRaiiTransactor.h"
+#include "Core/SqLiteStorage.h"
+
+#include <QDir>
+#include <QDomDocument>
+#include <QFileInfo>
+#include <QSqlQuery>
+#include <QtTest/QtTest>
+
+namespace {
+const int EventCount = 100000;
+const int TaskCount = 1000;
+const int EventsPerReport = 50;
+const QDateTime ReferenceDateTime(QDate(2019, 1, 1), QTime(8, 0));
+
+struct IndexDefinition
+{
+    const char *name;
+    const char *definition;
+};
+
+// the indexes created by the storage backends:
+const IndexDefinition Indexes[] = {
+    { "events_event_id", "`Events` (`event_id`)" },
+    { "events_task", "`Events` (`task`)" },
+    { "events_report_user", "`Events` (`report_id`, `user_id`)" },
+    { "events_start", "`Events` (`start`)" },
+    { "subscriptions_task", "`Subscriptions` (`task`)" }
+};
+
+void addIndexedColumn()
+{
+    QTest::addColumn<bool>("indexed");
+    QTest::newRow("without indexes") << false;
+    QTest::newRow("with indexes") << true;
+}
+}
+
+SqLiteStorageBenchmarks::SqLiteStorageBenchmarks()
+    : QObject()
+    , m_storage(new SqLiteStorage)
+    , m_localPath(QStringLiteral("./SqLiteStorageBenchmarkDatabase.db"))
+{
+}
+
+SqLiteStorageBenchmarks::~SqLiteStorageBenchmarks()
+{
+    delete m_storage;
+}
+
+void SqLiteStorageBenchmarks::setIndexesEnabled(bool enabled)
+{
+    for (const IndexDefinition &index : Indexes) {
+        const QString name = QString::fromLatin1(index.name);
+        QSqlQuery query(m_storage->database());
+        if (enabled) {
+            query.prepare(QStringLiteral("CREATE INDEX IF NOT EXISTS `%1` ON %2;")
+                          .arg(name, QString::fromLatin1(index.definition)));
+        } else {
+            query.prepare(QStringLiteral("DROP INDEX IF EXISTS `%1`;").arg(name));
+        }
+        QVERIFY(SqlStorage::runQuery(query));
+    }
+    // let the query planner know about the table sizes:
+    QSqlQuery query(m_storage->database());
+    query.prepare(QStringLiteral("ANALYZE;"));
+    QVERIFY(SqlStorage::runQuery(query));
+}
+
+void SqLiteStorageBenchmarks::initTestCase()
+{
+    QFileInfo file(m_localPath);
+    if (file.exists()) {
+        QDir dir(file.absoluteDir());
+        QVERIFY(dir.remove(file.fileName()));
+    }
+
+    m_configuration.installationId = 1;
+    m_configuration.user.setId(1);
+    m_configuration.localStorageType = CHARM_SQLITE_BACKEND_DESCRIPTOR;
+    m_configuration.localStorageDatabase = m_localPath;
+    m_configuration.newDatabase = true;
+    QVERIFY(m_storage->connect(m_configuration));
+
+    SqlRaiiTransactor transactor(m_storage->database());
+    for (int i = 1; i <= TaskCount; ++i) {
+        Task task;
+        task.setId(i);
+        task.setName(QStringLiteral("Task %1").arg(i));
+        QVERIFY(m_storage->addTask(task, transactor));
+        if (i % 2 == 0) {
+            QSqlQuery query(m_storage->database());
+            query.prepare(QStringLiteral("INSERT into Subscriptions VALUES (NULL, 1, :task);"));
+            query.bindValue(QStringLiteral(":task"), i);
+            QVERIFY(SqlStorage::runQuery(query));
+        }
+    }
+    for (int i = 0; i < EventCount; ++i) {
+        Event event;
+        event.setTaskId(i % TaskCount + 1);
+        event.setUserId(1);
+        event.setReportId(i / EventsPerReport + 1);
+        // about 15 events per day, going back in time:
+        const QDateTime start = ReferenceDateTime.addSecs(-qint64(i) * 5760);
+        event.setStartDateTime(start);
+        event.setEndDateTime(start.addSecs(3600));
+        QVERIFY(m_storage->addEvent(event, transactor).isValid());
+    }
+    QVERIFY(transactor.commit());
+}
+
+void SqLiteStorageBenchmarks::getEvent_data()
+{
+    addIndexedColumn();
+}
+
+void SqLiteStorageBenchmarks::getEvent()
+{
+    QFETCH(bool, indexed);
+    setIndexesEnabled(indexed);
+    Event event;
+    QBENCHMARK {
+        event = m_storage->getEvent(EventCount / 2);
+    }
+    QVERIFY(event.isValid());
+}
+
+void SqLiteStorageBenchmarks::modifyEvent_data()
+{
+    addIndexedColumn();
+}
+
+void SqLiteStorageBenchmarks::modifyEvent()
+{
+    QFETCH(bool, indexed);
+    setIndexesEnabled(indexed);
+    Event event = m_storage->getEvent(EventCount / 2);
+    QVERIFY(event.isValid());
+    int counter = 0;
+    QBENCHMARK {
+        event.setComment(QString::number(++counter));
+        QVERIFY(m_storage->modifyEvent(event));
+    }
+}
+
+void SqLiteStorageBenchmarks::eventsForTask_data()
+{
+    addIndexedColumn();
+}
+
+void SqLiteStorageBenchmarks::eventsForTask()
+{
+    // the filter used when deleting a task:
+    QFETCH(bool, indexed);
+    setIndexesEnabled(indexed);
+    int count = 0;
+    QBENCHMARK {
+        QSqlQuery query(m_storage->database());
+        query.prepare(QStringLiteral("SELECT COUNT(*) from Events WHERE task = :task;"));
+        query.bindValue(QStringLiteral(":task"), TaskCount / 2);
+        QVERIFY(SqlStorage::runQuery(query) && query.next());
+        count = query.value(0).toInt();
+    }
+    QCOMPARE(count, EventCount / TaskCount);
+}
+
+void SqLiteStorageBenchmarks::eventsForReport_data()
+{
+    addIndexedColumn();
+}
+
+void SqLiteStorageBenchmarks::eventsForReport()
+{
+    // the filter used by the TimesheetProcessor when removing a report:
+    QFETCH(bool, indexed);
+    setIndexesEnabled(indexed);
+    int count = 0;
+    QBENCHMARK {
+        QSqlQuery query(m_storage->database());
+        query.prepare(QStringLiteral(
+                          "SELECT COUNT(*) from Events WHERE report_id = :index and user_id = :userid;"));
+        query.bindValue(QStringLiteral(":index"), 42);
+        query.bindValue(QStringLiteral(":userid"), 1);
+        QVERIFY(SqlStorage::runQuery(query) && query.next());
+        count = query.value(0).toInt();
+    }
+    QCOMPARE(count, EventsPerReport);
+}
+
+void SqLiteStorageBenchmarks::getEventsInRange_data()
+{
+    addIndexedColumn();
+}
+
+void SqLiteStorageBenchmarks::getEventsInRange()
+{
+    QFETCH(bool, indexed);
+    setIndexesEnabled(indexed);
+    const QDateTime end(ReferenceDateTime.date(), QTime(0, 0));
+    const QDateTime start = end.addDays(-7);
+    EventList events;
+    QBENCHMARK {
+        events = m_storage->getEventsInRange(start, end);
+    }
+    QVERIFY(!events.isEmpty());
+}
+
+void SqLiteStorageBenchmarks::getAllTasks_data()
+{
+    addIndexedColumn();
+}
+
+void SqLiteStorageBenchmarks::getAllTasks()
+{
+    QFETCH(bool, indexed);
+    setIndexesEnabled(indexed);
+    TaskList tasks;
+    QBENCHMARK {
+        tasks = m_storage->getAllTasks();
+    }
+    QCOMPARE(tasks.size(), TaskCount);
+}
+
+void SqLiteStorageBenchmarks::addEvent_data()
+{
+    QTest::addColumn<bool>("singleStatement");
+    QTest::newRow("make and modify") << false;
+    QTest::newRow("addEvent") << true;
+}
+
+void SqLiteStorageBenchmarks::addEvent()
+{
+    QFETCH(bool, singleStatement);
+    setIndexesEnabled(true);
+    Event event;
+    event.setTaskId(1);
+    event.setUserId(1);
+    event.setStartDateTime(ReferenceDateTime);
+    event.setEndDateTime(ReferenceDateTime.addSecs(3600));
+    QBENCHMARK {
+        if (singleStatement) {
+            QVERIFY(m_storage->addEvent(event).isValid());
+        } else {
+            // the way events were created before addEvent():
+            Event newEvent = m_storage->makeEvent();
+            QVERIFY(newEvent.isValid());
+            const int id = newEvent.id();
+            newEvent = event;
+            newEvent.setId(id);
+            QVERIFY(m_storage->modifyEvent(newEvent));
+        }
+    }
+}
+
+void SqLiteStorageBenchmarks::preparedStatements_data()
+{
+    QTest::addColumn<QString>("statement");
+    QTest::addColumn<bool>("cached");
+    const QStringList statements = QStringList()
+                                   << QStringLiteral("getEvent")
+                                   << QStringLiteral("modifyEvent")
+                                   << QStringLiteral("getMetaData");
+    Q_FOREACH (const QString &statement, statements) {
+        QTest::newRow(qPrintable(statement + QStringLiteral(" prepared each time")))
+            << statement << false;
+        QTest::newRow(qPrintable(statement + QStringLiteral(" cached"))) << statement << true;
+    }
+}
+
+void SqLiteStorageBenchmarks::preparedStatements()
+{
+    QFETCH(QString, statement);
+    QFETCH(bool, cached);
+    setIndexesEnabled(true);
+
+    Event event = m_storage->getEvent(EventCount / 2);
+    QVERIFY(event.isValid());
+    const QString key = QStringLiteral("BenchmarkKey");
+    QVERIFY(m_storage->setMetaData(key, QStringLiteral("BenchmarkValue")));
+
+    // the uncached variants are the statements as they were run before the cache was added:
+    if (statement == QLatin1String("getEvent")) {
+        QBENCHMARK {
+            if (cached) {
+                QVERIFY(m_storage->getEvent(event.id()).isValid());
+            } else {
+                QSqlQuery query(m_storage->database());
+                query.prepare(QStringLiteral("SELECT * FROM Events WHERE event_id = :id;"));
+                query.bindValue(QStringLiteral(":id"), event.id());
+                QVERIFY(SqlStorage::runQuery(query) && query.next());
+            }
+        }
+    } else if (statement == QLatin1String("modifyEvent")) {
+        SqlRaiiTransactor transactor(m_storage->database());
+        QBENCHMARK {
+            if (cached) {
+                QVERIFY(m_storage->modifyEvent(event, transactor));
+            } else {
+                QSqlQuery query(m_storage->database());
+                query.prepare(QLatin1String("UPDATE Events set task = :task, comment = :comment, "
+                                            "start = :start, end = :end, user_id = :user, report_id = :report "
+                                            "where event_id = :id;"));
+                query.bindValue(QStringLiteral(":id"), event.id());
+                query.bindValue(QStringLiteral(":user"), event.userId());
+                query.bindValue(QStringLiteral(":task"), event.taskId());
+                query.bindValue(QStringLiteral(":report"), event.reportId());
+                query.bindValue(QStringLiteral(":comment"), event.comment());
+                query.bindValue(QStringLiteral(":start"), event.startDateTime());
+                query.bindValue(QStringLiteral(":end"), event.endDateTime());
+                QVERIFY(SqlStorage::runQuery(query));
+            }
+        }
+        QVERIFY(transactor.commit());
+    } else {
+        QBENCHMARK {
+            if (cached) {
+                QVERIFY(!m_storage->getMetaData(key).isEmpty());
+            } else {
+                QSqlQuery query(m_storage->database());
+                query.prepare(QStringLiteral("SELECT * FROM MetaData WHERE key = :key;"));
+                query.bindValue(QStringLiteral(":key"), key);
+                QVERIFY(SqlStorage::runQuery(query) && query.next());
+            }
+        }
+    }
+}
+
+void SqLiteStorageBenchmarks::bulkImport_data()
+{
+    QTest::addColumn<int>("eventCount");
+    QTest::newRow("20k") << 20000;
+    QTest::newRow("200k") << 200000;
+}
+
+void SqLiteStorageBenchmarks::bulkImport()
+{
+    // generate a database export in the format of the test export file, then measure
+    // how fast the storage takes it in:
+    QFETCH(int, eventCount);
+    const int taskCount = 100;
+    QDomDocument document(QStringLiteral("charmdatabase"));
+    QDomElement root = document.createElement(QStringLiteral("charmdatabase"));
+    root.setAttribute(QStringLiteral("version"), CHARM_DATABASE_VERSION);
+    document.appendChild(root);
+    QDomElement tasksElement = document.createElement(QStringLiteral("tasks"));
+    for (int i = 1; i <= taskCount; ++i) {
+        Task task;
+        task.setId(i);
+        task.setName(QStringLiteral("Task %1").arg(i));
+        task.setSubscribed(i % 2 == 0);
+        tasksElement.appendChild(task.toXml(document));
+    }
+    root.appendChild(tasksElement);
+    QDomElement eventsElement = document.createElement(QStringLiteral("events"));
+    const QDateTime reference(QDate(2019, 1, 1), QTime(8, 0));
+    for (int i = 1; i <= eventCount; ++i) {
+        Event event;
+        event.setId(i);
+        event.setTaskId(i % taskCount + 1);
+        event.setComment(QStringLiteral("Comment %1").arg(i % 50));
+        const QDateTime start = reference.addSecs(-qint64(i) * 5760);
+        event.setStartDateTime(start);
+        event.setEndDateTime(start.addSecs(3600));
+        eventsElement.appendChild(event.toXml(document));
+    }
+    root.appendChild(eventsElement);
+
+    TaskList tasks;
+    for (QDomElement element = tasksElement.firstChildElement(Task::tagName());
+         !element.isNull(); element = element.nextSiblingElement(Task::tagName()))
+        tasks << Task::fromXml(element, CHARM_DATABASE_VERSION);
+    EventList events;
+    events.reserve(eventCount);
+    for (QDomElement element = eventsElement.firstChildElement(Event::tagName());
+         !element.isNull(); element = element.nextSiblingElement(Event::tagName()))
+        events << Event::fromXml(element, CHARM_DATABASE_VERSION);
+    QCOMPARE(events.size(), eventCount);
+
+    // this replaces the benchmark data, it has to run last:
+    QBENCHMARK {
+        QVERIFY(m_storage->setAllTasksAndEvents(m_configuration.user, tasks, events).isEmpty());
+    }
+    QCOMPARE(m_storage->getAllEvents().size(), eventCount);
+    QCOMPARE(m_storage->getAllTasks().size(), taskCount);
+}
+
+void SqLiteStorageBenchmarks::cleanupTestCase()
+{
+    m_storage->disconnect();
+    if (QDir::home().exists(m_localPath)) {
+        bool result = QDir::home().remove(m_localPath);
+        QVERIFY(result);
+    }
+}
+
+QTEST_MAIN(SqLiteStorageBenchmarks)
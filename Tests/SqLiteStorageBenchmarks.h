@@ -0,0 +1,77 @@
+/*
+  SqLiteStorageBenchmarks.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SQLITESTORAGEBENCHMARKS_H
+#define SQLITESTORAGEBENCHMARKS_H
+
+#include <QObject>
+
+#include "Core/Configuration.h"
+#include "Core/SqlStorage.h"
+
+class SqLiteStorageBenchmarks : public QObject
+{
+    Q_OBJECT
+public:
+    SqLiteStorageBenchmarks();
+    ~SqLiteStorageBenchmarks() override;
+
+private:
+    void setIndexesEnabled(bool enabled);
+
+    SqlStorage *m_storage;
+    Configuration m_configuration;
+    QString m_localPath;
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void getEvent_data();
+    void getEvent();
+
+    void modifyEvent_data();
+    void modifyEvent();
+
+    void eventsForTask_data();
+    void eventsForTask();
+
+    void eventsForReport_data();
+    void eventsForReport();
+
+    void getEventsInRange_data();
+    void getEventsInRange();
+
+    void getAllTasks_data();
+    void getAllTasks();
+
+    void addEvent_data();
+    void addEvent();
+
+    void preparedStatements_data();
+    void preparedStatements();
+
+    void bulkImport_data();
+    void bulkImport();
+
+    void cleanupTestCase();
+};
+
+#endif
@@ -30,6 +30,7 @@
 #include <QDir>
 #include <QFileInfo>
 #include <QDateTime>
+#include <QSqlQuery>
 #include <QtTest/QtTest>
 
 SqLiteStorageTests::SqLiteStorageTests()
@@ -197,6 +198,38 @@ void SqLiteStorageTests::makeModifyDeleteEventsTest()
     QVERIFY(m_storage->getEvent(event2.id()).isValid());
 }
 
+void SqLiteStorageTests::addEventTest()
+{
+    QVERIFY(m_storage->deleteAllEvents());
+    Event event;
+    event.setId(4711); // ignored
+    event.setTaskId(1);
+    event.setUserId(1);
+    event.setReportId(42);
+    event.setComment(QStringLiteral("Event-Comment"));
+    event.setStartDateTime(QDateTime(QDate(2019, 3, 4), QTime(9, 0)));
+    event.setEndDateTime(QDateTime(QDate(2019, 3, 4), QTime(10, 30)));
+
+    const Event first = m_storage->addEvent(event);
+    QVERIFY(first.isValid());
+    QVERIFY(first.id() != event.id());
+    const Event second = m_storage->addEvent(event);
+    QVERIFY(second.isValid());
+    QVERIFY(second.id() != first.id());
+
+    // the stored events can be retrieved by their id, with all fields:
+    QCOMPARE(m_storage->getEvent(first.id()), first);
+    QCOMPARE(m_storage->getEvent(second.id()), second);
+    Event expected = event;
+    expected.setId(first.id());
+    QCOMPARE(first, expected);
+    QCOMPARE(m_storage->getAllEvents().size(), 2);
+
+    QVERIFY(m_storage->deleteEvent(first));
+    QVERIFY(m_storage->deleteEvent(second));
+    QVERIFY(m_storage->getAllEvents().isEmpty());
+}
+
 void SqLiteStorageTests::addDeleteSubscriptionsTest()
 {
     // this is a new database, so there should be no subscriptions
@@ -308,6 +341,93 @@ void SqLiteStorageTests::setGetMetaDataTest()
     QVERIFY(m_storage->getMetaData(Key2) == Value2);
 }
 
+void SqLiteStorageTests::getEventsInRangeTest()
+{
+    QVERIFY(m_storage->deleteAllEvents());
+    const QDateTime monday(QDate(2019, 3, 4), QTime(9, 0));
+    // one event per day for two weeks, alternating between tasks 1 and 2:
+    EventList created;
+    for (int day = 0; day < 14; ++day) {
+        Event event = m_storage->makeEvent();
+        QVERIFY(event.isValid());
+        event.setTaskId(day % 2 + 1);
+        event.setUserId(1);
+        event.setStartDateTime(monday.addDays(day));
+        event.setEndDateTime(monday.addDays(day).addSecs(3600));
+        QVERIFY(m_storage->modifyEvent(event));
+        created << event;
+    }
+
+    // the second week, start included, end excluded:
+    const QDateTime start(QDate(2019, 3, 11), QTime(9, 0));
+    const QDateTime end(QDate(2019, 3, 18), QTime(0, 0));
+    const EventList week = m_storage->getEventsInRange(start, end);
+    QCOMPARE(week, created.mid(7, 7));
+    QVERIFY(m_storage->getEventsInRange(start.addYears(1), end.addYears(1)).isEmpty());
+
+    const EventList task1 = m_storage->getEventsForTasks(TaskIdList() << 1, start, end);
+    QCOMPARE(task1.size(), 3);
+    Q_FOREACH (const Event &event, task1) {
+        QCOMPARE(event.taskId(), 1);
+        QVERIFY(event.startDateTime() >= start && event.startDateTime() < end);
+    }
+    QCOMPARE(m_storage->getEventsForTasks(TaskIdList() << 1 << 2, start, end), week);
+    QVERIFY(m_storage->getEventsForTasks(TaskIdList(), start, end).isEmpty());
+    QVERIFY(m_storage->getEventsForTasks(TaskIdList() << 3, start, end).isEmpty());
+}
+
+void SqLiteStorageTests::migrateIndexesTest()
+{
+    auto indexNames = [this]() {
+        QStringList names;
+        QSqlQuery query(m_storage->database());
+        query.prepare(QStringLiteral("SELECT name FROM sqlite_master WHERE type = 'index' "
+                                     "AND name NOT LIKE 'sqlite_%' ORDER BY name;"));
+        if (SqlStorage::runQuery(query)) {
+            while (query.next())
+                names << query.value(0).toString();
+        }
+        return names;
+    };
+    const QStringList expected = QStringList()
+                                 << QStringLiteral("events_event_id")
+                                 << QStringLiteral("events_report_user")
+                                 << QStringLiteral("events_start")
+                                 << QStringLiteral("events_task")
+                                 << QStringLiteral("subscriptions_task");
+    // new databases are created with the indexes:
+    QCOMPARE(indexNames(), expected);
+
+    // turn the database back into one of the previous version:
+    Q_FOREACH (const QString &name, expected) {
+        QSqlQuery query(m_storage->database());
+        query.prepare(QStringLiteral("DROP INDEX `%1`;").arg(name));
+        QVERIFY(SqlStorage::runQuery(query));
+    }
+    QVERIFY(m_storage->setMetaData(CHARM_DATABASE_VERSION_DESCRIPTOR,
+                                   QString::number(CHARM_DATABASE_VERSION_BEFORE_INDEXES)));
+    QVERIFY(indexNames().isEmpty());
+
+    QVERIFY(m_storage->verifyDatabase());
+    QCOMPARE(indexNames(), expected);
+    QCOMPARE(m_storage->getMetaData(CHARM_DATABASE_VERSION_DESCRIPTOR),
+             QString::number(CHARM_DATABASE_VERSION));
+}
+
+void SqLiteStorageTests::reconnectTest()
+{
+    // prepared queries must not outlive the connection they were prepared for:
+    const QString version = m_storage->getMetaData(CHARM_DATABASE_VERSION_DESCRIPTOR);
+    QVERIFY(!version.isEmpty());
+    QVERIFY(m_storage->disconnect());
+    QVERIFY(m_storage->connect(m_configuration));
+    QCOMPARE(m_storage->getMetaData(CHARM_DATABASE_VERSION_DESCRIPTOR), version);
+    const Event event = m_storage->addEvent(Event());
+    QVERIFY(event.isValid());
+    QCOMPARE(m_storage->getEvent(event.id()), event);
+    QVERIFY(m_storage->deleteEvent(event));
+}
+
 void SqLiteStorageTests::cleanupTestCase()
 {
     m_storage->disconnect();
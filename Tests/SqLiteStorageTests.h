@@ -52,12 +52,20 @@ private Q_SLOTS:
 
     void makeModifyDeleteEventsTest();
 
+    void addEventTest();
+
     void addDeleteSubscriptionsTest();
 
     void setGetMetaDataTest();
 
     void deleteTaskWithEventsTest();
 
+    void getEventsInRangeTest();
+
+    void migrateIndexesTest();
+
+    void reconnectTest();
+
     void cleanupTestCase();
 };
 
@@ -0,0 +1,154 @@
+/*
+  TaskStructureBenchmarks.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TaskStructureBenchmarks.h"
+
+#include "Charm/TaskModelAdapter.h"
+#include "Core/CharmDataModel.h"
+#include "Core/SmartNameCache.h"
+#include "Core/Task.h"
+
+#include <QtTest/QtTest>
+
+#include <algorithm>
+#include <random>
+
+namespace {
+Task makeTask(TaskId id, TaskId parent)
+{
+    Task task;
+    task.setId(id);
+    task.setParent(parent);
+    task.setName(QStringLiteral("Task %1").arg(id));
+    return task;
+}
+
+/** Generate a task tree of @p count tasks where every task has up to 10
+ * children. The tasks are shuffled, so parents usually do not precede
+ * their children. */
+TaskList generateTasks(int count)
+{
+    TaskList tasks;
+    tasks.reserve(count);
+    for (int i = 0; i < count; ++i)
+        tasks.append(makeTask(i + 1, i == 0 ? 0 : i / 10 + 1));
+    std::shuffle(tasks.begin(), tasks.end(), std::mt19937(42));
+    return tasks;
+}
+}
+
+void TaskStructureBenchmarks::validateTaskList_data()
+{
+    QTest::addColumn<int>("taskCount");
+    QTest::newRow("1k") << 1000;
+    QTest::newRow("10k") << 10000;
+    QTest::newRow("100k") << 100000;
+}
+
+void TaskStructureBenchmarks::validateTaskList()
+{
+    QFETCH(int, taskCount);
+    const TaskList tasks = generateTasks(taskCount);
+    Task::TaskListValidity validity = Task::NotATree;
+    QBENCHMARK {
+        validity = Task::validateTaskList(tasks);
+    }
+    QCOMPARE(validity, Task::ValidTaskList);
+}
+
+void TaskStructureBenchmarks::taskTreeTraversal_data()
+{
+    QTest::addColumn<TaskList>("tasks");
+
+    // a flat list of toplevel tasks, like a long customer list:
+    TaskList wide;
+    for (TaskId id = 1; id <= 20000; ++id)
+        wide << makeTask(id, 0);
+    QTest::newRow("wide") << wide;
+
+    // a chain of 100 levels, every level has 200 children:
+    TaskList deep;
+    TaskId parent = 0;
+    for (int level = 0; level < 100; ++level) {
+        const TaskId first = deep.size() + 1;
+        for (TaskId id = first; id < first + 200; ++id)
+            deep << makeTask(id, parent);
+        parent = first;
+    }
+    QTest::newRow("deep") << deep;
+}
+
+void TaskStructureBenchmarks::taskTreeTraversal()
+{
+    // visits every row the way a view does, through TaskModelAdapter::index()
+    // and parent(), which both ask the items for their row:
+    QFETCH(TaskList, tasks);
+    CharmDataModel model;
+    model.setAllTasks(tasks);
+    TaskModelAdapter adapter(&model);
+    int visited = 0;
+    QBENCHMARK {
+        visited = 0;
+        QList<QModelIndex> stack;
+        stack << QModelIndex();
+        while (!stack.isEmpty()) {
+            const QModelIndex parent = stack.takeLast();
+            const int rowCount = adapter.rowCount(parent);
+            for (int row = 0; row < rowCount; ++row) {
+                const QModelIndex index = adapter.index(row, 0, parent);
+                if (adapter.parent(index) != parent)
+                    QFAIL("Inconsistent task tree");
+                stack << index;
+                ++visited;
+            }
+        }
+    }
+    QCOMPARE(visited, tasks.size());
+}
+
+void TaskStructureBenchmarks::smartNameCacheAddTasks_data()
+{
+    QTest::addColumn<int>("taskCount");
+    QTest::newRow("1k") << 1000;
+    QTest::newRow("10k") << 10000;
+}
+
+void TaskStructureBenchmarks::smartNameCacheAddTasks()
+{
+    // adds the tasks one at a time, like the model does when tasks are created.
+    // Only 100 different names are used, so that many tasks need to be disambiguated:
+    QFETCH(int, taskCount);
+    TaskList tasks;
+    for (int i = 0; i < taskCount; ++i) {
+        Task task = makeTask(i + 1, i < 10 ? 0 : i / 10);
+        task.setName(QStringLiteral("Task %1").arg(i % 100));
+        tasks.append(task);
+    }
+    SmartNameCache cache;
+    QBENCHMARK {
+        cache.clearTasks();
+        Q_FOREACH (const Task &task, tasks)
+            cache.addTask(task);
+    }
+    QVERIFY(!cache.smartName(taskCount).isEmpty());
+}
+
+QTEST_MAIN(TaskStructureBenchmarks)
@@ -90,6 +90,58 @@ void TaskStructureTests::checkForTreenessTest()
     QCOMPARE(Task::checkForTreeness(tasks), directed);
 }
 
+Q_DECLARE_METATYPE(Task::TaskListValidity)
+
+void TaskStructureTests::validateTaskListTest_data()
+{
+    QTest::addColumn<TaskList>("tasks");
+    QTest::addColumn<Task::TaskListValidity>("validity");
+
+    auto makeTask = [](TaskId id, TaskId parent) {
+        Task task;
+        task.setId(id);
+        task.setParent(parent);
+        task.setName(QStringLiteral("Task %1").arg(id));
+        return task;
+    };
+
+    QTest::newRow("empty") << TaskList() << Task::ValidTaskList;
+    QTest::newRow("children before parents")
+        << (TaskList() << makeTask(3, 2) << makeTask(2, 1) << makeTask(1, 0) << makeTask(4, 1))
+        << Task::ValidTaskList;
+    QTest::newRow("duplicate ids")
+        << (TaskList() << makeTask(1, 0) << makeTask(2, 1) << makeTask(2, 0))
+        << Task::DuplicateTaskIds;
+    QTest::newRow("invalid task")
+        << (TaskList() << makeTask(1, 0) << Task())
+        << Task::NotATree;
+    QTest::newRow("orphan")
+        << (TaskList() << makeTask(1, 0) << makeTask(2, 5))
+        << Task::NotATree;
+    QTest::newRow("own parent")
+        << (TaskList() << makeTask(1, 0) << makeTask(2, 2))
+        << Task::NotATree;
+    QTest::newRow("cycle")
+        << (TaskList() << makeTask(1, 0) << makeTask(2, 4) << makeTask(3, 2) << makeTask(4, 3))
+        << Task::NotATree;
+
+    // deep enough to overflow the stack with a recursive traversal:
+    TaskList chain;
+    for (TaskId id = 1; id <= 100000; ++id)
+        chain << makeTask(id, id - 1);
+    QTest::newRow("long chain") << chain << Task::ValidTaskList;
+}
+
+void TaskStructureTests::validateTaskListTest()
+{
+    QFETCH(TaskList, tasks);
+    QFETCH(Task::TaskListValidity, validity);
+
+    QCOMPARE(Task::validateTaskList(tasks), validity);
+    QCOMPARE(Task::checkForTreeness(tasks), validity == Task::ValidTaskList);
+    QCOMPARE(Task::checkForUniqueTaskIds(tasks), validity != Task::DuplicateTaskIds);
+}
+
 void TaskStructureTests::mergeTaskListsTest_data()
 {
     QTest::addColumn<TaskList>("old");
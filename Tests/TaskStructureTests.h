@@ -43,6 +43,9 @@ private Q_SLOTS:
     void checkForTreenessTest_data();
     void checkForTreenessTest();
 
+    void validateTaskListTest_data();
+    void validateTaskListTest();
+
     void mergeTaskListsTest_data();
     void mergeTaskListsTest();
 };
@@ -140,11 +140,7 @@ void Database::initializeDatabase() throw (TimesheetProcessorException)
 
 void Database::addEvent(const Event &event, const SqlRaiiTransactor &t)
 {
-    Event newEvent = m_storage.makeEvent(t);
-    int id = newEvent.id();
-    newEvent = event;
-    newEvent.setId(id);
-    if (!m_storage.modifyEvent(newEvent, t))
+    if (!m_storage.addEvent(event, t).isValid())
         throw TimesheetProcessorException(QStringLiteral("Cannot add event"));
 }
 